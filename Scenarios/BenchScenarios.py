@@ -0,0 +1,356 @@
+# Scenario-scale benchmarks for tricycle
+#
+# Generates synthetic fleets of FusionPowerPlant and DecayStorage agents from
+# the scenario templates, runs them (and the shipped global tritium inputs in
+# scenarios/candu_inputs) through cyclus and reports for every run:
+#
+#   wall_s          wall clock time of the whole cyclus process
+#   peak_rss_mb     peak resident set size of the cyclus process
+#   step_mean_ms    mean wall time per time step
+#   step_p95_ms     95th percentile / max wall time of a single time step, when
+#   step_max_ms     cyclus logs its time steps at the requested verbosity
+#   db_mb           size of the output database
+#
+# Example:
+#
+#   python BenchScenarios.py --sizes 10 100 1000 10000 --out bench.json
+#   python BenchScenarios.py --baseline bench.json --out new.json
+#
+# With --baseline the script exits non-zero if any case got slower or bigger
+# than the baseline by more than --threshold.
+
+import argparse
+import csv
+import json
+import os
+import re
+import shutil
+import subprocess
+import sys
+import tempfile
+import time
+
+from GenFPPscript import (fill_region_template, process_deployment_data,
+                          read_csv_to_list)
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+CANDU_DIR = os.path.join(HERE, '..', 'scenarios', 'candu_inputs')
+
+FPP_TEMPLATE = os.path.join(HERE, 'FPP.tmpl')
+STORAGE_TEMPLATE = os.path.join(HERE, 'DecayStorage.tmpl')
+SIMULATION_TEMPLATE = os.path.join(HERE, 'Simulation.tmpl')
+REGION_TEMPLATE = os.path.join(HERE, 'Region.tmpl')
+INSTITUTION_TEMPLATE = os.path.join(HERE, 'Institution.tmpl')
+
+# Commodities wiring the synthetic fleet together:
+#   Tritium Supply -> DecayStorage -> FusionPowerPlant -> Helium/Lithium Sinks
+SUPPLY_COMMOD = 'Tritium'
+FUEL_COMMOD = 'TritiumFuel'
+
+SUPPLY_FACILITIES = """
+  <facility>
+    <name>Tritium Supply</name>
+    <config>
+      <Source>
+        <outcommod>{supply}</outcommod>
+        <outrecipe>T</outrecipe>
+        <throughput>{throughput}</throughput>
+      </Source>
+    </config>
+  </facility>
+
+  <facility>
+    <name>Lithium Supply</name>
+    <config>
+      <Source>
+        <outcommod>{lithium}</outcommod>
+        <outrecipe>{lithium_recipe}</outrecipe>
+      </Source>
+    </config>
+  </facility>
+
+  <facility>
+    <name>Byproduct Sink</name>
+    <config>
+      <Sink>
+        <in_commods>
+          <val>{helium}</val>
+          <val>{depleted}</val>
+        </in_commods>
+      </Sink>
+    </config>
+  </facility>
+"""
+
+STEP_PATTERN = re.compile(r'Current time:\s*(\d+)')
+
+
+def add_parse():
+    parser = argparse.ArgumentParser(
+        description='Scenario-scale benchmarks for tricycle')
+    parser.add_argument('--cyclus', default='cyclus',
+                        help='cyclus executable')
+    parser.add_argument('--sizes', type=int, nargs='*',
+                        default=[10, 100, 1000, 10000],
+                        help='total tricycle agents per synthetic scenario')
+    parser.add_argument('--storage-fraction', type=float, default=0.5,
+                        help='fraction of the agents that are DecayStorage')
+    parser.add_argument('--duration', type=int, default=120,
+                        help='time steps of the synthetic scenarios')
+    parser.add_argument('--fpp', default=os.path.join(HERE, 'FPPInput.csv'),
+                        help='FPP spec file, first row is the fleet plant')
+    parser.add_argument('--lazy-decay', action='store_true',
+                        help='run DecayStorage in lazy decay mode')
+    parser.add_argument('--explicit-inventory', action='store_true',
+                        help='record ExplicitInventory tables')
+    parser.add_argument('--no-candu', action='store_true',
+                        help='skip the scenarios/candu_inputs runs')
+    parser.add_argument('--verbosity', default='2',
+                        help='cyclus verbosity used to time single steps')
+    parser.add_argument('--repeat', type=int, default=1,
+                        help='runs per case, the fastest is reported')
+    parser.add_argument('--keep', help='directory to keep inputs and outputs')
+    parser.add_argument('--out', help='json file to write results to')
+    parser.add_argument('--csv', help='csv file to write results to')
+    parser.add_argument('--baseline', help='json results to compare against')
+    parser.add_argument('--threshold', type=float, default=0.2,
+                        help='relative regression tolerated by --baseline')
+    return parser.parse_args()
+
+
+# - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+# Synthetic scenario generation
+
+def fleet_counts(size, storage_fraction):
+    """
+    Splits size agents into (FusionPowerPlant, DecayStorage) counts, with at
+    least one of each
+    """
+    n_storage = max(1, int(round(size * storage_fraction)))
+    n_fpp = max(1, size - n_storage)
+    return n_fpp, n_storage
+
+
+def generate_scenario(fpp_spec, n_fpp, n_storage, duration, lazy_decay=False,
+                      explicit_inventory=False):
+    """
+    Returns a complete cyclus input with n_fpp copies of the plant in
+    fpp_spec (a row of an FPP spec file) fuelled through n_storage
+    DecayStorage facilities. Every agent is deployed by one DeployInst.
+    """
+    plant = dict(fpp_spec)
+    plant['name'] = 'BenchPlant'
+    plant['fuel_incommod'] = FUEL_COMMOD
+
+    storage = {'name': 'BenchStorage', 'incommod': SUPPLY_COMMOD,
+               'outcommod': FUEL_COMMOD,
+               # Keep the supply from being split among more storages than
+               # the plants need, so storages stay busy at every size
+               'throughput': 10.0 * n_fpp / n_storage,
+               'lazy_decay': str(lazy_decay).lower()}
+
+    with open(FPP_TEMPLATE, 'r') as template_file:
+        plant_xml = template_file.read().format(**plant)
+    with open(STORAGE_TEMPLATE, 'r') as template_file:
+        storage_xml = template_file.read().format(**storage)
+    support_xml = SUPPLY_FACILITIES.format(
+        supply=SUPPLY_COMMOD, throughput=10.0 * n_fpp,
+        lithium=plant['blanket_incommod'],
+        lithium_recipe=plant['blanket_inrecipe'],
+        helium=plant['he3_outcommod'], depleted=plant['blanket_outcommod'])
+
+    deployment = [
+        ('Tritium Supply', 1), ('Lithium Supply', 1), ('Byproduct Sink', 1),
+        ('BenchStorage', n_storage), ('BenchPlant', n_fpp)]
+    dep_list = [{'region_name': 'BenchRegion', 'institution': 'BenchInst',
+                 'prototypes': proto, 'build_times': 1,
+                 'lifetimes': duration, 'n_build': n}
+                for proto, n in deployment]
+    dep_map = process_deployment_data(dep_list)
+    regions = '\n'.join(
+        fill_region_template(region, inst_data, REGION_TEMPLATE,
+                             INSTITUTION_TEMPLATE)
+        for region, inst_data in dep_map.items())
+
+    with open(SIMULATION_TEMPLATE, 'r') as template_file:
+        template = template_file.read()
+    return template.format(
+        duration=duration,
+        explicit_inventory=str(explicit_inventory).lower(),
+        lithium_recipe=plant['blanket_inrecipe'],
+        facilities='\n'.join([support_xml, storage_xml, plant_xml]),
+        regions=regions)
+
+
+def candu_inputs():
+    """
+    Top-level inputs in scenarios/candu_inputs. The other files there are
+    snippets XIncluded by those.
+    """
+    inputs = []
+    for name in sorted(os.listdir(CANDU_DIR)):
+        path = os.path.join(CANDU_DIR, name)
+        if not name.endswith('.xml'):
+            continue
+        with open(path, 'r') as f:
+            if '<simulation' in f.read(512):
+                inputs.append(path)
+    return inputs
+
+
+def input_duration(path):
+    with open(path, 'r') as f:
+        match = re.search(r'<duration>\s*(\d+)\s*</duration>', f.read())
+    return int(match.group(1)) if match else None
+
+
+# - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+# Running and measuring
+
+def percentile(values, q):
+    if not values:
+        return None
+    values = sorted(values)
+    index = min(len(values) - 1, int(round(q * (len(values) - 1))))
+    return values[index]
+
+
+def run_cyclus(cyclus, infile, outfile, duration, verbosity):
+    """
+    Runs one simulation and returns its measurements. Single step latencies
+    come from the time between consecutive "Current time" log lines, so they
+    include the logging itself.
+    """
+    if os.path.exists(outfile):
+        os.remove(outfile)
+
+    cmd = [cyclus, '-v', verbosity, '-o', outfile, os.path.basename(infile)]
+    start = time.perf_counter()
+    proc = subprocess.Popen(cmd, cwd=os.path.dirname(infile),
+                            stdout=subprocess.PIPE, stderr=subprocess.STDOUT,
+                            universal_newlines=True)
+    step_times = []
+    tail = []
+    for line in proc.stdout:
+        if STEP_PATTERN.search(line):
+            step_times.append(time.perf_counter())
+        tail = (tail + [line])[-20:]
+    _, status, usage = os.wait4(proc.pid, 0)
+    wall = time.perf_counter() - start
+    proc.returncode = os.waitstatus_to_exitcode(status)
+
+    if proc.returncode != 0:
+        raise RuntimeError('{0} failed:\n{1}'.format(' '.join(cmd),
+                                                     ''.join(tail)))
+
+    # ru_maxrss is in kilobytes on Linux and bytes on macOS
+    rss_scale = 1.0 / 1024 if sys.platform != 'darwin' else 1.0 / 1024**2
+    steps = [1e3 * (b - a) for a, b in zip(step_times, step_times[1:])]
+    return {
+        'wall_s': wall,
+        'peak_rss_mb': usage.ru_maxrss * rss_scale,
+        'step_mean_ms': 1e3 * wall / duration if duration else None,
+        'step_p95_ms': percentile(steps, 0.95),
+        'step_max_ms': max(steps) if steps else None,
+        'db_mb': os.path.getsize(outfile) / 1024.0**2,
+    }
+
+
+def run_case(args, name, infile, duration, workdir, extra=None):
+    outfile = os.path.join(workdir, name + '.sqlite')
+    best = None
+    for _ in range(max(args.repeat, 1)):
+        result = run_cyclus(args.cyclus, infile, outfile, duration,
+                            args.verbosity)
+        if best is None or result['wall_s'] < best['wall_s']:
+            best = result
+    case = {'case': name, 'duration': duration}
+    case.update(extra or {})
+    case.update(best)
+    print(format_case(case), flush=True)
+    return case
+
+
+def format_case(case):
+    def fmt(value):
+        return '-' if value is None else '{0:.4g}'.format(value)
+    return ('{case:<28} wall {wall} s  rss {rss} MB  step {mean} ms '
+            '(p95 {p95}, max {max})  db {db} MB').format(
+                case=case['case'], wall=fmt(case['wall_s']),
+                rss=fmt(case['peak_rss_mb']), mean=fmt(case['step_mean_ms']),
+                p95=fmt(case['step_p95_ms']), max=fmt(case['step_max_ms']),
+                db=fmt(case['db_mb']))
+
+
+def compare(results, baseline_file, threshold):
+    """
+    Returns the cases whose wall time, peak RSS or database size grew by more
+    than threshold relative to the baseline
+    """
+    with open(baseline_file, 'r') as f:
+        baseline = {c['case']: c for c in json.load(f)}
+
+    regressions = []
+    for case in results:
+        base = baseline.get(case['case'])
+        if base is None:
+            continue
+        for key in ('wall_s', 'peak_rss_mb', 'db_mb'):
+            if base.get(key) and case[key] > base[key] * (1 + threshold):
+                regressions.append('{0}: {1} {2:.4g} -> {3:.4g}'.format(
+                    case['case'], key, base[key], case[key]))
+    return regressions
+
+
+def run_benchmarks():
+    args = add_parse()
+    fpp_spec = read_csv_to_list(args.fpp)[0]
+
+    workdir = args.keep or tempfile.mkdtemp(prefix='tricycle_bench_')
+    os.makedirs(workdir, exist_ok=True)
+
+    results = []
+    try:
+        for size in args.sizes:
+            n_fpp, n_storage = fleet_counts(size, args.storage_fraction)
+            name = 'synthetic_{0}'.format(size)
+            infile = os.path.join(workdir, name + '.xml')
+            with open(infile, 'w') as f:
+                f.write(generate_scenario(fpp_spec, n_fpp, n_storage,
+                                          args.duration, args.lazy_decay,
+                                          args.explicit_inventory))
+            results.append(run_case(args, name, infile, args.duration,
+                                    workdir, {'n_fpp': n_fpp,
+                                              'n_storage': n_storage}))
+
+        if not args.no_candu:
+            for infile in candu_inputs():
+                name = os.path.splitext(os.path.basename(infile))[0]
+                results.append(run_case(args, name, infile,
+                                        input_duration(infile), workdir))
+    finally:
+        if not args.keep:
+            shutil.rmtree(workdir, ignore_errors=True)
+
+    if args.out:
+        with open(args.out, 'w') as f:
+            json.dump(results, f, indent=2)
+    if args.csv:
+        keys = []
+        for case in results:
+            keys += [k for k in case if k not in keys]
+        with open(args.csv, 'w', newline='') as f:
+            writer = csv.DictWriter(f, fieldnames=keys)
+            writer.writeheader()
+            writer.writerows(results)
+
+    if args.baseline:
+        regressions = compare(results, args.baseline, args.threshold)
+        for line in regressions:
+            print('REGRESSION ' + line)
+        if regressions:
+            sys.exit(1)
+
+
+if __name__ == '__main__':
+    run_benchmarks()
@@ -0,0 +1,252 @@
+# Prefix-sharing scenario branching for tricycle
+#
+# Runs the time steps a set of variants have in common once, then forks every
+# variant from the cyclus snapshot taken at the end of that shared prefix:
+#
+#   1. the base input is run up to --branch-time; cyclus always snapshots the
+#      state of every agent at the end of a simulation
+#   2. each variant gets a copy of that database, with its state variable
+#      overrides written into the snapshot and the simulation duration set
+#      back to the full length
+#   3. the variants are restarted from their snapshots with cyclus --restart,
+#      --jobs of them at a time
+#
+# Variants are given as a json file mapping variant names to overrides per
+# prototype:
+#
+#   {
+#     "high_tbr": {"FPP_A": {"TBR": 1.2}},
+#     "late_storage": {"FPP_A": {"reserve_inventory": 8.0},
+#                      "Storage": {"max_tritium_inventory": 50.0}}
+#   }
+#
+# Overrides apply to the prototype and to every agent built from it. Only
+# scalar state variables can be overridden; deployment schedules (the vector
+# variables of DeployInst) are left as they are in the prefix.
+#
+# Each variant database holds the prefix run (time steps before the branch
+# time) and the restarted run, whose Info row names the prefix as its parent.
+#
+# Example:
+#
+#   python BranchScenarios.py base.xml variants.json --branch-time 600 \
+#       --jobs 8 --out-dir branches --summary branches.json
+
+import argparse
+import concurrent.futures
+import json
+import os
+import re
+import shutil
+import sqlite3
+import subprocess
+import time
+import uuid
+
+from BenchScenarios import input_duration
+
+
+def add_parse():
+    parser = argparse.ArgumentParser(
+        description='Runs scenario variants from a shared prefix snapshot')
+    parser.add_argument('infile', help='base cyclus input')
+    parser.add_argument('variants', help='json file of variant overrides')
+    parser.add_argument('--branch-time', type=int, required=True,
+                        help='time step the variants start to differ at')
+    parser.add_argument('--duration', type=int,
+                        help='full duration, defaults to the base input\'s')
+    parser.add_argument('--cyclus', default='cyclus',
+                        help='cyclus executable')
+    parser.add_argument('--jobs', type=int, default=os.cpu_count(),
+                        help='variants run at the same time')
+    parser.add_argument('--out-dir', default='branches',
+                        help='directory for the prefix and variant databases')
+    parser.add_argument('--prefix-db',
+                        help='reuse the snapshot of an earlier prefix run')
+    parser.add_argument('--summary', help='json file to write run info to')
+    return parser.parse_args()
+
+
+# - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+# Prefix
+
+def run_prefix(cyclus, infile, branch_time, outfile):
+    """
+    Runs infile for its first branch_time time steps into outfile and returns
+    the wall time taken
+    """
+    with open(infile, 'r') as f:
+        text = f.read()
+    text, n = re.subn(r'<duration>\s*\d+\s*</duration>',
+                      '<duration>{0}</duration>'.format(branch_time), text,
+                      count=1)
+    if n != 1:
+        raise ValueError('no <duration> found in ' + infile)
+
+    # Next to the original so that relative paths and XIncludes still work
+    prefix_input = os.path.join(os.path.dirname(os.path.abspath(infile)),
+                                '.prefix_' + os.path.basename(infile))
+    with open(prefix_input, 'w') as f:
+        f.write(text)
+
+    if os.path.exists(outfile):
+        os.remove(outfile)
+    start = time.perf_counter()
+    try:
+        run([cyclus, '-o', os.path.abspath(outfile),
+             os.path.basename(prefix_input)],
+            cwd=os.path.dirname(prefix_input))
+    finally:
+        os.remove(prefix_input)
+    return time.perf_counter() - start
+
+
+def run(cmd, cwd=None):
+    proc = subprocess.run(cmd, cwd=cwd, stdout=subprocess.PIPE,
+                          stderr=subprocess.STDOUT, universal_newlines=True)
+    if proc.returncode != 0:
+        tail = ''.join(proc.stdout.splitlines(True)[-20:])
+        raise RuntimeError('{0} failed:\n{1}'.format(' '.join(cmd), tail))
+
+
+def snapshot_sim(db, branch_time):
+    """
+    Id of the simulation in db with a snapshot at branch_time
+    """
+    conn = sqlite3.connect(db)
+    try:
+        rows = conn.execute('SELECT SimId FROM Snapshots WHERE Time = ?',
+                            (branch_time,)).fetchall()
+    finally:
+        conn.close()
+    if not rows:
+        raise ValueError('{0} has no snapshot at time {1}'.format(
+            db, branch_time))
+    return rows[-1][0]
+
+
+# - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+# Variants
+
+def state_tables(conn):
+    tables = conn.execute("SELECT name FROM sqlite_master WHERE type = 'table'"
+                          " AND name LIKE 'AgentState%Info'").fetchall()
+    columns = {}
+    for (table,) in tables:
+        info = conn.execute('PRAGMA table_info("{0}")'.format(table))
+        columns[table] = set(row[1] for row in info)
+    return columns
+
+
+def prototype_agents(conn, sim_id, prototype):
+    """
+    Ids of the prototype and of every agent built from it
+    """
+    ids = [r[0] for r in conn.execute(
+        'SELECT AgentId FROM Prototypes WHERE SimId = ? AND Prototype = ?',
+        (sim_id, prototype))]
+    ids += [r[0] for r in conn.execute(
+        'SELECT AgentId FROM AgentEntry WHERE SimId = ? AND Prototype = ?',
+        (sim_id, prototype))]
+    if not ids:
+        raise ValueError('no prototype named ' + prototype)
+    return ids
+
+
+def apply_overrides(db, sim_id, branch_time, duration, overrides):
+    """
+    Writes a variant's overrides into the snapshot of sim_id in db and
+    extends the simulation to duration
+    """
+    conn = sqlite3.connect(db)
+    try:
+        tables = state_tables(conn)
+        for prototype, variables in overrides.items():
+            ids = prototype_agents(conn, sim_id, prototype)
+            marks = ','.join('?' * len(ids))
+            for var, value in variables.items():
+                if isinstance(value, bool):
+                    value = int(value)
+                updated = 0
+                for table, columns in tables.items():
+                    if var not in columns:
+                        continue
+                    updated += conn.execute(
+                        'UPDATE "{0}" SET "{1}" = ? WHERE SimId = ? AND '
+                        'SimTime = ? AND AgentId IN ({2})'.format(
+                            table, var, marks),
+                        [value, sim_id, branch_time] + ids).rowcount
+                if updated == 0:
+                    raise ValueError('{0} has no state variable {1}'.format(
+                        prototype, var))
+        conn.execute('UPDATE Info SET Duration = ? WHERE SimId = ?',
+                     (duration, sim_id))
+        conn.commit()
+    finally:
+        conn.close()
+
+
+def run_variant(cyclus, name, overrides, prefix_db, sim_id, branch_time,
+                duration, out_dir):
+    db = os.path.abspath(os.path.join(out_dir, name + '.sqlite'))
+    shutil.copyfile(prefix_db, db)
+    apply_overrides(db, sim_id, branch_time, duration, overrides)
+
+    restart = '{0}:{1}:{2}'.format(db, uuid.UUID(bytes=bytes(sim_id)),
+                                   branch_time)
+    start = time.perf_counter()
+    run([cyclus, '--restart', restart, '-o', db])
+    return {'variant': name, 'db': db,
+            'wall_s': time.perf_counter() - start}
+
+
+def run_branches():
+    args = add_parse()
+    with open(args.variants, 'r') as f:
+        variants = json.load(f)
+    duration = args.duration or input_duration(args.infile)
+    if duration is None or args.branch_time >= duration:
+        raise ValueError('--branch-time must be before the end of the run')
+
+    os.makedirs(args.out_dir, exist_ok=True)
+    prefix_db = args.prefix_db
+    prefix_s = 0.0
+    if prefix_db is None:
+        prefix_db = os.path.join(args.out_dir, 'prefix.sqlite')
+        prefix_s = run_prefix(args.cyclus, args.infile, args.branch_time,
+                              prefix_db)
+        print('prefix ({0} steps) {1:.4g} s'.format(args.branch_time,
+                                                    prefix_s), flush=True)
+    sim_id = snapshot_sim(prefix_db, args.branch_time)
+
+    results = []
+    with concurrent.futures.ThreadPoolExecutor(max(args.jobs, 1)) as pool:
+        futures = [pool.submit(run_variant, args.cyclus, name, overrides,
+                               prefix_db, sim_id, args.branch_time, duration,
+                               args.out_dir)
+                   for name, overrides in variants.items()]
+        for future in concurrent.futures.as_completed(futures):
+            result = future.result()
+            print('{variant:<28} {wall_s:.4g} s  {db}'.format(**result),
+                  flush=True)
+            results.append(result)
+
+    # Time the variants would have taken from scratch, assuming the prefix
+    # costs about the same in every one of them
+    saved = prefix_s * (len(results) - 1)
+    print('{0} variants, about {1:.4g} s of prefix simulation shared'.format(
+        len(results), saved))
+
+    if args.summary:
+        with open(args.summary, 'w') as f:
+            json.dump({'prefix_db': prefix_db,
+                       'prefix_sim': str(uuid.UUID(bytes=bytes(sim_id))),
+                       'branch_time': args.branch_time,
+                       'duration': duration, 'prefix_s': prefix_s,
+                       'variants': sorted(results,
+                                          key=lambda r: r['variant'])},
+                      f, indent=2)
+
+
+if __name__ == '__main__':
+    run_branches()
@@ -0,0 +1,368 @@
+# Parameter sweeps of FusionPowerPlant scenarios for tricycle
+#
+# Expands ranges of FPP.tmpl fields into the cartesian product of cases,
+# builds a complete cyclus input for each from an FPP spec file and a
+# deployment file (the GenFPPscript.py inputs), runs the cases on every core
+# and collects their key outputs into one results file.
+#
+# Parameters are given as NAME=VALUES, where VALUES is either a comma
+# separated list or an inclusive START:STOP:STEP range:
+#
+#   python SweepScenarios.py --fpp FPPInput.csv --dep DeployIn.csv \
+#       --param TBR=1.05:1.25:0.01 --param reserve_inventory=4,6,8,10 \
+#       --duration 240 --out sweep.csv
+#
+# Swept values apply to every plant in the spec file, or only to the ones
+# named with --plant. Fuel comes straight from a Source per fuel commodity,
+# limited by --supply-throughput and --supply-inventory.
+#
+# Every case is a separate cyclus process. Idle workers take the next case
+# from a shared queue, so a core only sits idle once no case is left to
+# start.
+#
+# Results have one row per case: the swept values, then
+#
+#   plants          FusionPowerPlants built
+#   plants_started  plants holding sequestered tritium at their last record
+#   storage_kg      tritium storage, excess and sequestered inventories of
+#   excess_kg       all plants at their last record
+#   sequestered_kg
+#   supply_kg       tritium delivered by the fuel sources over the run
+#   wall_s          wall clock time of the cyclus process
+#   error           why the case failed, empty when it ran
+
+import argparse
+import concurrent.futures
+import csv
+import itertools
+import json
+import os
+import shutil
+import sqlite3
+import subprocess
+import tempfile
+import time
+
+from GenFPPscript import (fill_region_template, process_deployment_data,
+                          read_csv_to_list)
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+
+FPP_TEMPLATE = os.path.join(HERE, 'FPP.tmpl')
+SIMULATION_TEMPLATE = os.path.join(HERE, 'Simulation.tmpl')
+REGION_TEMPLATE = os.path.join(HERE, 'Region.tmpl')
+INSTITUTION_TEMPLATE = os.path.join(HERE, 'Institution.tmpl')
+
+SOURCE_FACILITY = """
+  <facility>
+    <name>{name}</name>
+    <config>
+      <Source>
+        <outcommod>{commod}</outcommod>
+        <outrecipe>{recipe}</outrecipe>
+        <throughput>{throughput}</throughput>
+        <inventory_size>{inventory}</inventory_size>
+      </Source>
+    </config>
+  </facility>
+"""
+
+SINK_FACILITY = """
+  <facility>
+    <name>Byproduct Sink</name>
+    <config>
+      <Sink>
+        <in_commods>
+{commods}
+        </in_commods>
+      </Sink>
+    </config>
+  </facility>
+"""
+
+RESULT_KEYS = ['plants', 'plants_started', 'storage_kg', 'excess_kg',
+               'sequestered_kg', 'supply_kg', 'wall_s', 'error']
+
+
+def add_parse():
+    parser = argparse.ArgumentParser(
+        description='Parameter sweeps of FusionPowerPlant scenarios')
+    parser.add_argument('--fpp', default=os.path.join(HERE, 'FPPInput.csv'),
+                        help='FPP spec file')
+    parser.add_argument('--dep', default=os.path.join(HERE, 'DeployIn.csv'),
+                        help='FPP deployment file')
+    parser.add_argument('--param', action='append', default=[],
+                        metavar='NAME=VALUES',
+                        help='FPP.tmpl field and its values, repeatable')
+    parser.add_argument('--plant', action='append',
+                        help='plant the swept values apply to, default all')
+    parser.add_argument('--duration', type=int, default=120,
+                        help='time steps of every case')
+    parser.add_argument('--supply-throughput', type=float, default=1e299,
+                        help='tritium each fuel source ships per time step')
+    parser.add_argument('--supply-inventory', type=float, default=1e299,
+                        help='tritium each fuel source holds in total')
+    parser.add_argument('--cyclus', default='cyclus',
+                        help='cyclus executable')
+    parser.add_argument('--jobs', type=int, default=os.cpu_count(),
+                        help='cases run at the same time')
+    parser.add_argument('--keep', help='directory to keep inputs and outputs')
+    parser.add_argument('--out', default='sweep.csv',
+                        help='csv file to write results to')
+    parser.add_argument('--json', help='json file to write results to')
+    parser.add_argument('--dry-run', action='store_true',
+                        help='only list the cases')
+    return parser.parse_args()
+
+
+# - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+# Cases
+
+def parse_values(text):
+    """
+    Values of a comma separated list or an inclusive START:STOP:STEP range.
+    Integers stay integers, so that fields like buy_frequency still parse.
+    """
+    def number(token):
+        token = token.strip()
+        try:
+            return int(token)
+        except ValueError:
+            return float(token)
+
+    if ':' not in text:
+        return [number(v) for v in text.split(',') if v.strip()]
+
+    parts = text.split(':')
+    if len(parts) != 3:
+        raise ValueError('range must be START:STOP:STEP, got ' + text)
+    start, stop, step = [number(p) for p in parts]
+    if step <= 0 or stop < start:
+        raise ValueError('empty range ' + text)
+    n = int((stop - start) / step + 1e-9) + 1
+    if all(isinstance(v, int) for v in (start, stop, step)):
+        return [start + i * step for i in range(n)]
+    # Rounded so that 1.05 + 2 * 0.05 prints as 1.15 in the input
+    return [round(start + i * step, 12) for i in range(n)]
+
+
+def parse_params(specs, fields):
+    params = []
+    for spec in specs:
+        name, sep, values = spec.partition('=')
+        name = name.strip()
+        if not sep:
+            raise ValueError('--param must be NAME=VALUES, got ' + spec)
+        if name not in fields:
+            raise ValueError('{0} is not a field of the FPP spec file'.format(
+                name))
+        params.append((name, parse_values(values)))
+    return params
+
+
+def expand_cases(params):
+    """
+    Cartesian product of the parameter values, as a list of {name: value}
+    """
+    names = [name for name, _ in params]
+    return [dict(zip(names, values))
+            for values in itertools.product(*[v for _, v in params])]
+
+
+def case_name(index, values):
+    parts = ['{0}{1}'.format(k, v) for k, v in values.items()]
+    return '_'.join(['case{0:04d}'.format(index)] + parts)
+
+
+# - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+# Input generation
+
+def generate_input(fpp_list, dep_list, values, plants, duration, throughput,
+                   inventory):
+    """
+    Returns a complete cyclus input with the plants of fpp_list, with values
+    substituted into the ones named in plants (all when None), deployed as
+    in dep_list. Fuel and blanket feed come from Sources, byproducts go to
+    one Sink.
+    """
+    with open(FPP_TEMPLATE, 'r') as template_file:
+        fpp_template = template_file.read()
+
+    plant_xml = []
+    for fpp in fpp_list:
+        spec = dict(fpp)
+        if plants is None or spec['name'] in plants:
+            spec.update({k: str(v) for k, v in values.items()})
+        plant_xml.append(fpp_template.format(**spec))
+
+    # One source per fuel and blanket commodity, built with the first
+    # deployment's institution
+    sources = []
+    for commod in sorted(set(f['fuel_incommod'] for f in fpp_list)):
+        sources.append(('Supply ' + commod, commod, 'T', throughput,
+                        inventory))
+    for commod, recipe in sorted(set((f['blanket_incommod'],
+                                      f['blanket_inrecipe'])
+                                     for f in fpp_list)):
+        sources.append(('Supply ' + commod, commod, recipe, 1e299, 1e299))
+    support_xml = [SOURCE_FACILITY.format(name=name, commod=commod,
+                                          recipe=recipe, throughput=tp,
+                                          inventory=inv)
+                   for name, commod, recipe, tp, inv in sources]
+    sinks = sorted(set(f['he3_outcommod'] for f in fpp_list) |
+                   set(f['blanket_outcommod'] for f in fpp_list))
+    support_xml.append(SINK_FACILITY.format(commods='\n'.join(
+        '          <val>{0}</val>'.format(c) for c in sinks)))
+
+    first = dep_list[0]
+    support = [{'region_name': first['region_name'],
+                'institution': first['institution'], 'prototypes': proto,
+                'build_times': 1, 'lifetimes': duration, 'n_build': 1}
+               for proto in [s[0] for s in sources] + ['Byproduct Sink']]
+    dep_map = process_deployment_data(support + dep_list)
+    regions = '\n'.join(
+        fill_region_template(region, inst_data, REGION_TEMPLATE,
+                             INSTITUTION_TEMPLATE)
+        for region, inst_data in dep_map.items())
+
+    with open(SIMULATION_TEMPLATE, 'r') as template_file:
+        template = template_file.read()
+    return template.format(
+        duration=duration, explicit_inventory='false',
+        lithium_recipe=fpp_list[0]['blanket_inrecipe'],
+        facilities='\n'.join(support_xml + plant_xml), regions=regions)
+
+
+# - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+# Running and collecting
+
+def collect(db, fuel_commods):
+    """
+    Key outputs of a finished case from its output database
+    """
+    conn = sqlite3.connect(db)
+    try:
+        plants = conn.execute(
+            "SELECT COUNT(*) FROM AgentEntry WHERE Spec LIKE "
+            "'%FusionPowerPlant'").fetchone()[0]
+        # FPPInventories may be decimated, but always holds the last step
+        # of every plant
+        last = conn.execute(
+            'SELECT SUM(TritiumStorage), SUM(TritiumExcess), '
+            'SUM(TritiumSequestered), SUM(TritiumSequestered > 0) '
+            'FROM FPPInventories AS f WHERE Time = '
+            '(SELECT MAX(Time) FROM FPPInventories WHERE AgentId = f.AgentId)'
+        ).fetchone()
+        marks = ','.join('?' * len(fuel_commods))
+        supply = conn.execute(
+            'SELECT SUM(r.Quantity) FROM Transactions AS t JOIN Resources AS r'
+            ' ON t.SimId = r.SimId AND t.ResourceId = r.ResourceId'
+            ' WHERE t.Commodity IN ({0})'.format(marks),
+            list(fuel_commods)).fetchone()[0]
+    finally:
+        conn.close()
+    return {'plants': plants, 'plants_started': last[3] or 0,
+            'storage_kg': last[0] or 0.0, 'excess_kg': last[1] or 0.0,
+            'sequestered_kg': last[2] or 0.0, 'supply_kg': supply or 0.0}
+
+
+def run_case(cyclus, name, values, infile, workdir, fuel_commods, keep):
+    outfile = os.path.join(workdir, name + '.sqlite')
+    if os.path.exists(outfile):
+        os.remove(outfile)
+
+    result = dict(values)
+    result['case'] = name
+    start = time.perf_counter()
+    proc = subprocess.run([cyclus, '-o', outfile, infile], cwd=workdir,
+                          stdout=subprocess.PIPE, stderr=subprocess.STDOUT,
+                          universal_newlines=True)
+    result['wall_s'] = time.perf_counter() - start
+    if proc.returncode != 0:
+        # One bad case should not cost the rest of the sweep
+        tail = proc.stdout.strip().splitlines()[-1:] or ['']
+        result['error'] = 'cyclus exited with {0}: {1}'.format(
+            proc.returncode, tail[0])
+        return result
+
+    result.update(collect(outfile, fuel_commods))
+    result['error'] = ''
+    if not keep:
+        os.remove(outfile)
+        os.remove(infile)
+    return result
+
+
+def write_results(results, names, csv_file, json_file):
+    keys = ['case'] + names + RESULT_KEYS
+    if csv_file:
+        with open(csv_file, 'w', newline='') as f:
+            writer = csv.DictWriter(f, fieldnames=keys, extrasaction='ignore')
+            writer.writeheader()
+            writer.writerows(results)
+    if json_file:
+        with open(json_file, 'w') as f:
+            json.dump(results, f, indent=2)
+
+
+def run_sweep():
+    args = add_parse()
+    fpp_list = read_csv_to_list(args.fpp)
+    dep_list = read_csv_to_list(args.dep)
+
+    names = set(f['name'] for f in fpp_list)
+    missing = set(d['prototypes'] for d in dep_list) - names
+    if missing:
+        raise ValueError('no FPP spec for ' + ', '.join(sorted(missing)))
+    if args.plant and not set(args.plant) <= names:
+        raise ValueError('--plant names a plant not in ' + args.fpp)
+
+    params = parse_params(args.param, fpp_list[0].keys())
+    cases = expand_cases(params)
+    param_names = [name for name, _ in params]
+    print('{0} cases over {1}'.format(len(cases), ', '.join(param_names)
+                                      or 'no parameters'), flush=True)
+    if args.dry_run:
+        for i, values in enumerate(cases):
+            print(case_name(i, values))
+        return
+
+    workdir = args.keep or tempfile.mkdtemp(prefix='tricycle_sweep_')
+    os.makedirs(workdir, exist_ok=True)
+    fuel_commods = sorted(set(f['fuel_incommod'] for f in fpp_list))
+
+    results = []
+    start = time.perf_counter()
+    try:
+        with concurrent.futures.ThreadPoolExecutor(max(args.jobs, 1)) as pool:
+            futures = []
+            for i, values in enumerate(cases):
+                name = case_name(i, values)
+                infile = os.path.join(workdir, name + '.xml')
+                with open(infile, 'w') as f:
+                    f.write(generate_input(fpp_list, dep_list, values,
+                                           args.plant, args.duration,
+                                           args.supply_throughput,
+                                           args.supply_inventory))
+                futures.append(pool.submit(run_case, args.cyclus, name,
+                                           values, infile, workdir,
+                                           fuel_commods, args.keep))
+            for n, future in enumerate(
+                    concurrent.futures.as_completed(futures)):
+                result = future.result()
+                results.append(result)
+                print('[{0}/{1}] {case:<40} {wall_s:.4g} s {error}'.format(
+                    n + 1, len(futures), **result), flush=True)
+    finally:
+        if not args.keep:
+            shutil.rmtree(workdir, ignore_errors=True)
+
+    results.sort(key=lambda r: r['case'])
+    write_results(results, param_names, args.out, args.json)
+    failed = sum(1 for r in results if r['error'])
+    print('{0} cases in {1:.4g} s, {2} failed'.format(
+        len(results), time.perf_counter() - start, failed))
+
+
+if __name__ == '__main__':
+    run_sweep()
@@ -0,0 +1,140 @@
+// age_binned_inventory.cc
+
+#include "age_binned_inventory.h"
+
+#include <algorithm>
+
+namespace tricycle {
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+AgeBinnedInventory::AgeBinnedInventory(int n_bins, int bin_width) {
+  Init(n_bins, bin_width);
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void AgeBinnedInventory::Init(int n_bins, int bin_width) {
+  bins_.assign(std::max(n_bins, 1), Bin());
+  bin_width_ = std::max(bin_width, 1);
+  head_ = 0;
+  phase_ = 0;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void AgeBinnedInventory::Deposit(double tritium) {
+  if (tritium > 0) {
+    bins_[head_].tritium += tritium;
+  }
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+double AgeBinnedInventory::Take(int bin, double tritium) {
+  Bin& b = bins_[Slot(bin)];
+  if (b.tritium <= 0) {
+    return 0;
+  }
+  double taken = std::min(tritium, b.tritium);
+  double fraction = taken / b.tritium;
+  b.helium3 -= b.helium3 * fraction;
+  b.tritium -= taken;
+  if (fraction >= 1) {
+    b.tritium = 0;
+    b.helium3 = 0;
+  }
+  return taken;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+double AgeBinnedInventory::Withdraw(double tritium, Order order,
+                                    double* mean_age) {
+  double taken = 0;
+  double age_sum = 0;
+  int n = bins_.size();
+  for (int i = 0; i < n && taken < tritium; ++i) {
+    int bin = (order == kFifo) ? n - 1 - i : i;
+    double qty = Take(bin, tritium - taken);
+    taken += qty;
+    age_sum += qty * age(bin);
+  }
+  if (mean_age != 0) {
+    *mean_age = taken > 0 ? age_sum / taken : 0;
+  }
+  return taken;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void AgeBinnedInventory::Decay(double surviving) {
+  for (size_t i = 0; i < bins_.size(); ++i) {
+    double decayed = bins_[i].tritium * (1 - surviving);
+    bins_[i].tritium -= decayed;
+    bins_[i].helium3 += decayed;
+  }
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+bool AgeBinnedInventory::Advance() {
+  if (++phase_ < bin_width_) {
+    return false;
+  }
+  phase_ = 0;
+
+  int n = bins_.size();
+  if (n == 1) {
+    return false;
+  }
+  // The oldest slot becomes the new youngest bin; what was in it stays
+  // with the (new) oldest bin
+  int oldest = Slot(n - 1);
+  Bin& next_oldest = bins_[Slot(n - 2)];
+  next_oldest.tritium += bins_[oldest].tritium;
+  next_oldest.helium3 += bins_[oldest].helium3;
+  bins_[oldest] = Bin();
+  head_ = oldest;
+  return true;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void AgeBinnedInventory::Save(std::vector<double>* tritium,
+                              std::vector<double>* helium3, int* phase) const {
+  tritium->resize(bins_.size());
+  helium3->resize(bins_.size());
+  for (size_t i = 0; i < bins_.size(); ++i) {
+    (*tritium)[i] = bins_[Slot(i)].tritium;
+    (*helium3)[i] = bins_[Slot(i)].helium3;
+  }
+  *phase = phase_;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void AgeBinnedInventory::Restore(const std::vector<double>& tritium,
+                                 const std::vector<double>& helium3,
+                                 int phase) {
+  bins_.assign(bins_.size(), Bin());
+  head_ = 0;
+  size_t n = std::min(bins_.size(), std::min(tritium.size(), helium3.size()));
+  for (size_t i = 0; i < n; ++i) {
+    bins_[i].tritium = tritium[i];
+    bins_[i].helium3 = helium3[i];
+  }
+  phase_ = std::min(std::max(phase, 0), bin_width_ - 1);
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+double AgeBinnedInventory::age(int bin) const {
+  // The youngest bin holds deposits 0 to phase_ time steps old, and bin i
+  // the bin_width_ time steps before those
+  if (bin == 0) {
+    return phase_ / 2.0;
+  }
+  return phase_ + (bin - 1) * bin_width_ + (bin_width_ + 1) / 2.0;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+double AgeBinnedInventory::quantity() const {
+  double total = 0;
+  for (size_t i = 0; i < bins_.size(); ++i) {
+    total += bins_[i].tritium;
+  }
+  return total;
+}
+
+}  // namespace tricycle
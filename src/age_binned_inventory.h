@@ -0,0 +1,88 @@
+#ifndef CYCLUS_TRICYCLE_AGE_BINNED_INVENTORY_H_
+#define CYCLUS_TRICYCLE_AGE_BINNED_INVENTORY_H_
+
+#include <cstddef>
+#include <vector>
+
+namespace tricycle {
+
+/// @class AgeBinnedInventory
+/// Tritium inventory kept as per-vintage totals in a ring of fixed age bins,
+/// instead of one record per received lot. Bin 0 holds the youngest
+/// tritium; every bin_width time steps each bin moves one place older, and
+/// whatever is in the oldest bin stays there. Every operation costs at most
+/// O(number of bins), however many lots went in.
+///
+/// Each bin also keeps the helium-3 its tritium has decayed into since it
+/// was deposited, whether or not that helium is still physically present.
+class AgeBinnedInventory {
+ public:
+  enum Order { kFifo, kLifo };
+
+  explicit AgeBinnedInventory(int n_bins = 1, int bin_width = 1);
+
+  /// Empties the inventory and sets its layout
+  void Init(int n_bins, int bin_width);
+
+  /// Adds freshly received tritium to the youngest bin
+  void Deposit(double tritium);
+
+  /// Takes up to tritium kg out, oldest bins first for kFifo or youngest
+  /// first for kLifo, and returns the amount taken. If mean_age is given it
+  /// is set to the mean age in time steps of the tritium taken.
+  double Withdraw(double tritium, Order order, double* mean_age = 0);
+
+  /// Decays every bin, given the surviving fraction for the elapsed time
+  void Decay(double surviving);
+
+  /// Ages the inventory by one time step. Returns whether the bins moved
+  /// one place older.
+  bool Advance();
+
+  /// Copies the tritium and helium-3 of every bin, youngest first, and the
+  /// time steps since the youngest bin was opened, e.g. to save them
+  void Save(std::vector<double>* tritium, std::vector<double>* helium3,
+            int* phase) const;
+
+  /// Sets the bins to values written by Save. Bins beyond those given are
+  /// left empty.
+  void Restore(const std::vector<double>& tritium,
+               const std::vector<double>& helium3, int phase);
+
+  size_t size() const { return bins_.size(); }
+
+  /// Tritium and grown helium-3 of bin, 0 being the youngest
+  double tritium(int bin) const { return bins_[Slot(bin)].tritium; }
+  double helium3(int bin) const { return bins_[Slot(bin)].helium3; }
+
+  /// Mean age in time steps of the tritium in bin, assuming its deposits
+  /// were spread evenly over the time the bin was open. The oldest bin also
+  /// holds everything older than its age range.
+  double age(int bin) const;
+
+  /// Total tritium over all bins
+  double quantity() const;
+
+ private:
+  struct Bin {
+    Bin() : tritium(0), helium3(0) {}
+    double tritium;
+    double helium3;
+  };
+
+  /// Index in bins_ of the bin-th youngest bin
+  int Slot(int bin) const { return (head_ + bin) % bins_.size(); }
+
+  /// Moves fraction of bin's content out and returns the tritium moved
+  double Take(int bin, double tritium);
+
+  std::vector<Bin> bins_;
+  int bin_width_;
+  int head_;
+  /// Time steps since the youngest bin was opened
+  int phase_;
+};
+
+}  // namespace tricycle
+
+#endif  // CYCLUS_TRICYCLE_AGE_BINNED_INVENTORY_H_
@@ -0,0 +1,124 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "age_binned_inventory.h"
+
+namespace tricycle {
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+TEST(AgeBinnedInventoryTest, DepositsAge) {
+  AgeBinnedInventory inv(3, 1);
+  inv.Deposit(1.0);
+  inv.Advance();
+  inv.Deposit(2.0);
+
+  EXPECT_DOUBLE_EQ(2.0, inv.tritium(0));
+  EXPECT_DOUBLE_EQ(1.0, inv.tritium(1));
+  EXPECT_DOUBLE_EQ(0.0, inv.age(0));
+  EXPECT_DOUBLE_EQ(1.0, inv.age(1));
+  EXPECT_DOUBLE_EQ(3.0, inv.quantity());
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+TEST(AgeBinnedInventoryTest, OldestBinKeepsEverything) {
+  AgeBinnedInventory inv(2, 1);
+  inv.Deposit(1.0);
+  for (int i = 0; i < 5; ++i) {
+    inv.Advance();
+  }
+  inv.Deposit(2.0);
+
+  EXPECT_DOUBLE_EQ(2.0, inv.tritium(0));
+  EXPECT_DOUBLE_EQ(1.0, inv.tritium(1));
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+TEST(AgeBinnedInventoryTest, WideBins) {
+  // Deposits only move on once a bin has been open for bin_width steps
+  AgeBinnedInventory inv(3, 4);
+  inv.Deposit(1.0);
+  for (int i = 0; i < 3; ++i) {
+    inv.Advance();
+  }
+  EXPECT_DOUBLE_EQ(1.0, inv.tritium(0));
+  EXPECT_DOUBLE_EQ(1.5, inv.age(0));
+
+  inv.Advance();
+  EXPECT_DOUBLE_EQ(1.0, inv.tritium(1));
+  EXPECT_DOUBLE_EQ(2.5, inv.age(1));
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+TEST(AgeBinnedInventoryTest, FifoAndLifo) {
+  AgeBinnedInventory fifo(3, 1);
+  fifo.Deposit(1.0);
+  fifo.Advance();
+  fifo.Advance();
+  fifo.Deposit(1.0);
+  AgeBinnedInventory lifo = fifo;
+
+  double age;
+  EXPECT_DOUBLE_EQ(1.5, fifo.Withdraw(1.5, AgeBinnedInventory::kFifo, &age));
+  EXPECT_DOUBLE_EQ(0.5, fifo.tritium(0));
+  EXPECT_DOUBLE_EQ(0.0, fifo.tritium(2));
+  EXPECT_NEAR(2.0 / 1.5, age, 1e-12);
+
+  EXPECT_DOUBLE_EQ(1.5, lifo.Withdraw(1.5, AgeBinnedInventory::kLifo, &age));
+  EXPECT_DOUBLE_EQ(0.0, lifo.tritium(0));
+  EXPECT_DOUBLE_EQ(0.5, lifo.tritium(2));
+  EXPECT_NEAR(1.0 / 1.5, age, 1e-12);
+
+  // Asking for more than there is empties the inventory
+  EXPECT_DOUBLE_EQ(0.5, lifo.Withdraw(10, AgeBinnedInventory::kLifo));
+  EXPECT_DOUBLE_EQ(0.0, lifo.quantity());
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+TEST(AgeBinnedInventoryTest, DecayGrowsHelium) {
+  AgeBinnedInventory inv(2, 1);
+  inv.Deposit(1.0);
+  inv.Decay(0.9);
+  inv.Advance();
+  inv.Deposit(1.0);
+  inv.Decay(0.9);
+
+  EXPECT_DOUBLE_EQ(0.9, inv.tritium(0));
+  EXPECT_NEAR(0.1, inv.helium3(0), 1e-12);
+  EXPECT_DOUBLE_EQ(0.81, inv.tritium(1));
+  EXPECT_NEAR(0.19, inv.helium3(1), 1e-12);
+
+  // Withdrawing part of a bin takes the same part of its helium-3
+  inv.Withdraw(0.405, AgeBinnedInventory::kFifo);
+  EXPECT_NEAR(0.095, inv.helium3(1), 1e-12);
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+TEST(AgeBinnedInventoryTest, SaveRestore) {
+  AgeBinnedInventory inv(3, 2);
+  inv.Deposit(1.0);
+  EXPECT_FALSE(inv.Advance());
+  EXPECT_TRUE(inv.Advance());
+  inv.Deposit(2.0);
+  inv.Decay(0.5);
+  EXPECT_FALSE(inv.Advance());
+
+  std::vector<double> tritium, helium3;
+  int phase;
+  inv.Save(&tritium, &helium3, &phase);
+  AgeBinnedInventory restored(3, 2);
+  restored.Restore(tritium, helium3, phase);
+
+  // The restored inventory ages on in step with the original
+  for (size_t i = 0; i < inv.size(); ++i) {
+    EXPECT_DOUBLE_EQ(inv.tritium(i), restored.tritium(i));
+    EXPECT_DOUBLE_EQ(inv.helium3(i), restored.helium3(i));
+    EXPECT_DOUBLE_EQ(inv.age(i), restored.age(i));
+  }
+  EXPECT_EQ(inv.Advance(), restored.Advance());
+  for (size_t i = 0; i < inv.size(); ++i) {
+    EXPECT_DOUBLE_EQ(inv.tritium(i), restored.tritium(i));
+  }
+}
+
+}  // namespace tricycle
@@ -0,0 +1,136 @@
+// blanket_state.cc
+
+#include "blanket_state.h"
+
+#include <algorithm>
+#include <sstream>
+
+#include "nuclides.h"
+
+using cyclus::CompMap;
+using cyclus::Composition;
+using cyclus::Material;
+
+namespace tricycle {
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void BlanketState::Fill(Material::Ptr feed) {
+  double qty = feed->quantity();
+  if (qty <= 0) {
+    return;
+  }
+
+  const CompMap& mass = feed->comp()->mass();
+  double total = 0;
+  for (CompMap::const_iterator it = mass.begin(); it != mass.end(); ++it) {
+    total += it->second;
+  }
+
+  for (CompMap::const_iterator it = mass.begin(); it != mass.end(); ++it) {
+    AddNuclide(it->first, qty * it->second / total);
+  }
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void BlanketState::Fill(const CompMap& mass) {
+  for (CompMap::const_iterator it = mass.begin(); it != mass.end(); ++it) {
+    AddNuclide(it->first, it->second);
+  }
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void BlanketState::AddNuclide(int nuc, double mass) {
+  switch (nuc) {
+    case kLithium6Id:
+      li6_ += mass;
+      break;
+    case kLithium7Id:
+      li7_ += mass;
+      break;
+    case kHelium4Id:
+      he4_ += mass;
+      break;
+    case kTritiumId:
+      tritium_ += mass;
+      break;
+    default:
+      other_[nuc] += mass;
+      other_mass_ += mass;
+  }
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+BlanketState BlanketState::Extract(double qty) {
+  BlanketState chunk;
+  double total = quantity();
+  if (total <= 0 || qty <= 0) {
+    return chunk;
+  }
+
+  double frac = std::min(qty / total, 1.0);
+  chunk.li6_ = li6_ * frac;
+  chunk.li7_ = li7_ * frac;
+  chunk.he4_ = he4_ * frac;
+  chunk.tritium_ = tritium_ * frac;
+  li6_ -= chunk.li6_;
+  li7_ -= chunk.li7_;
+  he4_ -= chunk.he4_;
+  tritium_ -= chunk.tritium_;
+
+  for (CompMap::iterator it = other_.begin(); it != other_.end(); ++it) {
+    double nuc_mass = it->second * frac;
+    chunk.other_[it->first] = nuc_mass;
+    it->second -= nuc_mass;
+  }
+  chunk.other_mass_ = other_mass_ * frac;
+  other_mass_ -= chunk.other_mass_;
+
+  return chunk;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void BlanketState::Breed(double li6, double li7, double he4) {
+  if (li6 > li6_ + cyclus::eps_rsrc() || li7 > li7_ + cyclus::eps_rsrc()) {
+    std::stringstream ss;
+    ss << "blanket holds " << li6_ << " kg Li-6 and " << li7_
+       << " kg Li-7, cannot burn " << li6 << " kg and " << li7 << " kg";
+    throw cyclus::ValueError(ss.str());
+  }
+
+  li6_ = std::max(li6_ - li6, 0.0);
+  li7_ = std::max(li7_ - li7, 0.0);
+  he4_ += he4;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+CompMap BlanketState::mass() const {
+  CompMap mass(other_);
+  if (li6_ > 0) {
+    mass[kLithium6Id] = li6_;
+  }
+  if (li7_ > 0) {
+    mass[kLithium7Id] = li7_;
+  }
+  if (he4_ > 0) {
+    mass[kHelium4Id] = he4_;
+  }
+  if (tritium_ > 0) {
+    mass[kTritiumId] = tritium_;
+  }
+  return mass;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+Composition::Ptr BlanketState::comp() const {
+  return Composition::CreateFromMass(mass());
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+Material::Ptr BlanketState::ToMaterial(cyclus::Agent* creator) const {
+  if (creator == NULL) {
+    return Material::CreateUntracked(quantity(), comp());
+  }
+  return Material::Create(creator, quantity(), comp());
+}
+
+}  // namespace tricycle
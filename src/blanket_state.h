@@ -0,0 +1,63 @@
+#ifndef CYCLUS_TRICYCLE_BLANKET_STATE_H_
+#define CYCLUS_TRICYCLE_BLANKET_STATE_H_
+
+#include "cyclus.h"
+
+namespace tricycle {
+
+/// @class BlanketState
+/// Nuclide amounts (kg) of an in-core breeding blanket. The nuclides that
+/// breeding touches every time step are plain members, so a breeding step
+/// is a handful of floating point operations. Anything else the blanket feed
+/// carries is kept in a mass map that is only touched on blanket turnover.
+/// The blanket is only turned into a cyclus::Material when it has to leave
+/// the core.
+class BlanketState {
+ public:
+  BlanketState() : li6_(0), li7_(0), he4_(0), tritium_(0), other_mass_(0) {}
+
+  double li6() const { return li6_; }
+  double li7() const { return li7_; }
+  double he4() const { return he4_; }
+  double tritium() const { return tritium_; }
+  double quantity() const {
+    return li6_ + li7_ + he4_ + tritium_ + other_mass_;
+  }
+
+  /// Loads feed material into the blanket
+  void Fill(cyclus::Material::Ptr feed);
+
+  /// Loads nuclide masses (kg), as returned by mass()
+  void Fill(const cyclus::CompMap& mass);
+
+  /// Nuclide masses (kg) of the blanket, to save it across a restart
+  cyclus::CompMap mass() const;
+
+  /// Removes qty kg with the current blanket composition
+  BlanketState Extract(double qty);
+
+  /// Burns li6 and li7 kg of lithium and generates he4 kg of helium-4.
+  /// @throws cyclus::ValueError if the blanket does not hold enough lithium
+  void Breed(double li6, double li7, double he4);
+
+  /// Composition of the blanket
+  cyclus::Composition::Ptr comp() const;
+
+  /// Creates a material holding the whole blanket state. With a NULL
+  /// creator the material is untracked.
+  cyclus::Material::Ptr ToMaterial(cyclus::Agent* creator) const;
+
+ private:
+  void AddNuclide(int nuc, double mass);
+
+  double li6_;
+  double li7_;
+  double he4_;
+  double tritium_;
+  double other_mass_;
+  cyclus::CompMap other_;
+};
+
+}  // namespace tricycle
+
+#endif  // CYCLUS_TRICYCLE_BLANKET_STATE_H_
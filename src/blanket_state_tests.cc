@@ -0,0 +1,69 @@
+#include <gtest/gtest.h>
+
+#include "blanket_state.h"
+#include "cyclus.h"
+#include "nuclides.h"
+
+using cyclus::Composition;
+using cyclus::Material;
+using cyclus::toolkit::MatQuery;
+
+namespace tricycle {
+namespace {
+
+Composition::Ptr lithium_feed() {
+  cyclus::CompMap m;
+  m[kLithium6Id] = 0.3;
+  m[kLithium7Id] = 0.7;
+  return Composition::CreateFromMass(m);
+}
+
+}  // namespace
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+TEST(BlanketStateTest, FillAndBreed) {
+  BlanketState blanket;
+  blanket.Fill(Material::CreateUntracked(100, lithium_feed()));
+
+  EXPECT_DOUBLE_EQ(30, blanket.li6());
+  EXPECT_DOUBLE_EQ(70, blanket.li7());
+
+  blanket.Breed(1, 2, 0.5);
+  EXPECT_DOUBLE_EQ(29, blanket.li6());
+  EXPECT_DOUBLE_EQ(68, blanket.li7());
+  EXPECT_DOUBLE_EQ(0.5, blanket.he4());
+  EXPECT_DOUBLE_EQ(97.5, blanket.quantity());
+
+  EXPECT_THROW(blanket.Breed(100, 0, 0), cyclus::ValueError);
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+TEST(BlanketStateTest, ExtractKeepsComposition) {
+  BlanketState blanket;
+  blanket.Fill(Material::CreateUntracked(100, lithium_feed()));
+  blanket.Breed(10, 0, 10);
+
+  BlanketState waste = blanket.Extract(10);
+  EXPECT_DOUBLE_EQ(10, waste.quantity());
+  EXPECT_DOUBLE_EQ(90, blanket.quantity());
+  EXPECT_DOUBLE_EQ(2, waste.li6());
+
+  Material::Ptr mat = Material::CreateUntracked(waste.quantity(), waste.comp());
+  EXPECT_NEAR(1, MatQuery(mat).mass(kHelium4Id), 1e-9);
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+TEST(BlanketStateTest, MassRoundTrip) {
+  BlanketState blanket;
+  blanket.Fill(Material::CreateUntracked(100, lithium_feed()));
+  blanket.Breed(10, 0, 10);
+
+  BlanketState restored;
+  restored.Fill(blanket.mass());
+  EXPECT_DOUBLE_EQ(blanket.li6(), restored.li6());
+  EXPECT_DOUBLE_EQ(blanket.li7(), restored.li7());
+  EXPECT_DOUBLE_EQ(blanket.he4(), restored.he4());
+  EXPECT_DOUBLE_EQ(blanket.quantity(), restored.quantity());
+}
+
+}  // namespace tricycle
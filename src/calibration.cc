@@ -0,0 +1,414 @@
+// calibration.cc
+
+#include "calibration.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <sstream>
+#include <stdexcept>
+
+namespace tricycle {
+
+namespace {
+
+/// The field of a plant spec a fit parameter sets, NULL if none
+double* PlantField(PlantSpec* spec, const std::string& name) {
+  if (name == "fusion_power") return &spec->fusion_power;
+  if (name == "TBR") return &spec->TBR;
+  if (name == "reserve_inventory") return &spec->reserve_inventory;
+  if (name == "sequestered_equilibrium") {
+    return &spec->sequestered_equilibrium;
+  }
+  if (name == "tritium_startup_fraction") {
+    return &spec->tritium_startup_fraction;
+  }
+  if (name == "Li7_contribution") return &spec->Li7_contribution;
+  if (name == "buy_quantity") return &spec->buy_quantity;
+  return NULL;
+}
+
+/// The field of the market a fit parameter sets, NULL if none
+double* SupplyField(SupplySpec* supply, const std::string& name) {
+  if (name == "initial_inventory") return &supply->initial_inventory;
+  if (name == "external_supply") return &supply->external_supply;
+  if (name == "sales") return &supply->sales;
+  if (name == "throughput") return &supply->throughput;
+  if (name == "capacity") return &supply->capacity;
+  return NULL;
+}
+
+/// Splits a parameter name into its prototype, empty for all, and field
+void SplitName(const std::string& name, std::string* prototype,
+               std::string* field) {
+  size_t dot = name.find('.');
+  *prototype = dot == std::string::npos ? "" : name.substr(0, dot);
+  *field = dot == std::string::npos ? name : name.substr(dot + 1);
+}
+
+/// Whether a fit parameter only takes whole numbers of time steps
+bool IsStep(const FitParam& param) {
+  std::string prototype, field;
+  SplitName(param.name, &prototype, &field);
+  return field == "supply_end";
+}
+
+double ParseNumber(const std::string& text, const std::string& spec) {
+  std::stringstream ss(text);
+  double value;
+  ss >> value;
+  if (ss.fail() || !ss.eof()) {
+    throw std::invalid_argument("bad number '" + text + "' in " + spec);
+  }
+  return value;
+}
+
+}  // namespace
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+ReferenceCurve ReadReferenceCurve(std::istream& in) {
+  std::vector<std::pair<double, double> > points;
+  std::string line;
+  bool header = true;
+  while (std::getline(in, line)) {
+    if (line.find_first_not_of(" \t\r\n") == std::string::npos) {
+      continue;
+    }
+    if (header) {
+      header = false;
+      continue;
+    }
+    std::stringstream ss(line);
+    double year, tritium;
+    char comma;
+    ss >> year >> comma >> tritium;
+    if (ss.fail() || comma != ',') {
+      throw std::invalid_argument("bad reference point: " + line);
+    }
+    points.push_back(std::make_pair(year, tritium));
+  }
+  if (points.empty()) {
+    throw std::invalid_argument("reference curve has no points");
+  }
+
+  std::sort(points.begin(), points.end());
+  ReferenceCurve curve;
+  for (size_t i = 0; i < points.size(); ++i) {
+    curve.years.push_back(points[i].first);
+    curve.tritium.push_back(points[i].second);
+  }
+  return curve;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+double Interpolate(const std::vector<double>& xs, const std::vector<double>& ys,
+                   double x) {
+  if (x <= xs.front()) {
+    return ys.front();
+  }
+  if (x >= xs.back()) {
+    return ys.back();
+  }
+  int hi = std::upper_bound(xs.begin(), xs.end(), x) - xs.begin();
+  int lo = hi - 1;
+  double frac = (x - xs[lo]) / (xs[hi] - xs[lo]);
+  return ys[lo] + frac * (ys[hi] - ys[lo]);
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+FitParam ParseFitParam(const std::string& spec) {
+  size_t eq = spec.find('=');
+  if (eq == std::string::npos) {
+    throw std::invalid_argument("fit parameter must be NAME=LOWER:UPPER, got " +
+                                spec);
+  }
+  FitParam param;
+  param.name = spec.substr(0, eq);
+
+  std::vector<std::string> parts;
+  std::stringstream ss(spec.substr(eq + 1));
+  std::string part;
+  while (std::getline(ss, part, ':')) {
+    parts.push_back(part);
+  }
+  if (parts.size() < 2 || parts.size() > 3) {
+    throw std::invalid_argument("fit parameter must be NAME=LOWER:UPPER, got " +
+                                spec);
+  }
+  param.lower = ParseNumber(parts[0], spec);
+  param.upper = ParseNumber(parts[1], spec);
+  param.start = parts.size() == 3 ? ParseNumber(parts[2], spec)
+                                  : std::numeric_limits<double>::quiet_NaN();
+  if (param.upper < param.lower) {
+    throw std::invalid_argument("empty bounds in " + spec);
+  }
+  return param;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+FitResult NelderMead(const std::function<double(const std::vector<double>&)>& f,
+                     const std::vector<double>& start,
+                     const std::vector<double>& lower,
+                     const std::vector<double>& upper, int max_evaluations,
+                     double tolerance) {
+  int n = start.size();
+  FitResult result;
+
+  // Search in coordinates scaled to the unit box
+  auto point = [&](const std::vector<double>& u) {
+    std::vector<double> x(n);
+    for (int j = 0; j < n; ++j) {
+      double clamped = std::min(std::max(u[j], 0.0), 1.0);
+      x[j] = lower[j] + clamped * (upper[j] - lower[j]);
+    }
+    return x;
+  };
+  auto eval = [&](const std::vector<double>& u) {
+    ++result.evaluations;
+    return f(point(u));
+  };
+
+  std::vector<std::vector<double> > simplex(n + 1, std::vector<double>(n));
+  for (int j = 0; j < n; ++j) {
+    double width = upper[j] - lower[j];
+    simplex[0][j] = width > 0 ? (start[j] - lower[j]) / width : 0;
+  }
+  for (int i = 1; i <= n; ++i) {
+    simplex[i] = simplex[0];
+    // A tenth of the box along each axis, inwards from the edges
+    double& u = simplex[i][i - 1];
+    u += u > 0.9 ? -0.1 : 0.1;
+  }
+  std::vector<double> values(n + 1);
+  for (int i = 0; i <= n; ++i) {
+    values[i] = eval(simplex[i]);
+  }
+
+  std::vector<int> order(n + 1);
+  while (result.evaluations < max_evaluations) {
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(),
+              [&](int a, int b) { return values[a] < values[b]; });
+    int best = order[0];
+    int worst = order[n];
+    int second = order[n > 0 ? n - 1 : 0];
+    if (n == 0 || values[worst] - values[best] <= tolerance) {
+      break;
+    }
+
+    std::vector<double> centroid(n, 0.0);
+    for (int i = 0; i <= n; ++i) {
+      if (i == worst) {
+        continue;
+      }
+      for (int j = 0; j < n; ++j) {
+        centroid[j] += simplex[i][j] / n;
+      }
+    }
+    auto along = [&](double t) {
+      std::vector<double> u(n);
+      for (int j = 0; j < n; ++j) {
+        u[j] = centroid[j] + t * (simplex[worst][j] - centroid[j]);
+      }
+      return u;
+    };
+
+    std::vector<double> reflected = along(-1);
+    double f_reflected = eval(reflected);
+    if (f_reflected < values[best]) {
+      std::vector<double> expanded = along(-2);
+      double f_expanded = eval(expanded);
+      if (f_expanded < f_reflected) {
+        simplex[worst] = expanded;
+        values[worst] = f_expanded;
+      } else {
+        simplex[worst] = reflected;
+        values[worst] = f_reflected;
+      }
+    } else if (f_reflected < values[second]) {
+      simplex[worst] = reflected;
+      values[worst] = f_reflected;
+    } else {
+      bool outside = f_reflected < values[worst];
+      std::vector<double> contracted = along(outside ? -0.5 : 0.5);
+      double f_contracted = eval(contracted);
+      if (f_contracted < (outside ? f_reflected : values[worst])) {
+        simplex[worst] = contracted;
+        values[worst] = f_contracted;
+      } else {
+        // Shrink everything towards the best vertex
+        for (int i = 0; i <= n; ++i) {
+          if (i == best) {
+            continue;
+          }
+          for (int j = 0; j < n; ++j) {
+            simplex[i][j] =
+                simplex[best][j] + 0.5 * (simplex[i][j] - simplex[best][j]);
+          }
+          values[i] = eval(simplex[i]);
+        }
+      }
+    }
+  }
+
+  int best = std::min_element(values.begin(), values.end()) - values.begin();
+  result.x = point(simplex[best]);
+  result.error = values[best];
+  return result;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+Calibration::Calibration(const std::vector<PlantSpec>& specs,
+                         const std::vector<Deployment>& deployments,
+                         const SupplySpec& supply, int duration, double dt,
+                         double start_year, const ReferenceCurve& reference,
+                         const std::vector<FitParam>& params)
+    : specs_(specs),
+      deployments_(deployments),
+      supply_(supply),
+      duration_(duration),
+      dt_(dt),
+      start_year_(start_year),
+      reference_(reference),
+      params_(params) {
+  for (FitParam& param : params_) {
+    std::string prototype, field;
+    SplitName(param.name, &prototype, &field);
+    PlantSpec spec;
+    SupplySpec market;
+    bool known = field == "supply_end" || PlantField(&spec, field) != NULL ||
+                 (prototype.empty() && SupplyField(&market, field) != NULL);
+    if (!known) {
+      throw std::invalid_argument("cannot fit " + param.name);
+    }
+    if (std::isnan(param.start)) {
+      param.start = (param.lower + param.upper) / 2;
+    }
+  }
+  // Fails here rather than on the first evaluation
+  FuelCycleEngine(specs_, deployments_, supply_, duration_, dt_);
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void Calibration::Apply(const std::vector<double>& x,
+                        std::vector<PlantSpec>* specs,
+                        SupplySpec* supply) const {
+  for (size_t p = 0; p < params_.size(); ++p) {
+    std::string prototype, field;
+    SplitName(params_[p].name, &prototype, &field);
+    if (field == "supply_end") {
+      supply->supply_end = std::lround(x[p]);
+      continue;
+    }
+    double* market = SupplyField(supply, field);
+    if (market != NULL && prototype.empty()) {
+      *market = x[p];
+      continue;
+    }
+    for (PlantSpec& spec : *specs) {
+      if (prototype.empty() || spec.name == prototype) {
+        *PlantField(&spec, field) = x[p];
+      }
+    }
+  }
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+FuelCycleEngine Calibration::Run(const std::vector<double>& x) const {
+  std::vector<PlantSpec> specs = specs_;
+  SupplySpec supply = supply_;
+  Apply(x, &specs, &supply);
+  FuelCycleEngine engine(specs, deployments_, supply, duration_, dt_);
+  engine.Run();
+  return engine;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+double Calibration::Error(const std::vector<double>& x) const {
+  FuelCycleEngine engine = Run(x);
+
+  // Records are taken at the end of each time step
+  std::vector<double> years, tritium;
+  for (const StepRecord& rec : engine.records()) {
+    years.push_back(start_year_ + (rec.time + 1) * dt_ / kYearSeconds);
+    tritium.push_back(TotalTritium(rec));
+  }
+  if (years.empty()) {
+    return 0;
+  }
+
+  double sum = 0;
+  int n = 0;
+  for (size_t i = 0; i < reference_.years.size(); ++i) {
+    double year = reference_.years[i];
+    if (year < years.front() || year > years.back()) {
+      continue;
+    }
+    double diff = Interpolate(years, tritium, year) - reference_.tritium[i];
+    sum += diff * diff;
+    ++n;
+  }
+  return n > 0 ? std::sqrt(sum / n) : 0;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+FitResult Calibration::Fit(int max_evaluations, double tolerance) const {
+  std::vector<double> start, lower, upper;
+  for (const FitParam& param : params_) {
+    start.push_back(param.start);
+    lower.push_back(param.lower);
+    upper.push_back(param.upper);
+  }
+  auto error = [this](const std::vector<double>& x) { return Error(x); };
+
+  // The error is flat between whole time steps of supply_end, so a simplex
+  // only moves it by chance. Each step within the bounds and the run is
+  // tried instead, with the other parameters held, and the best is kept as
+  // the whole step the engine ran.
+  auto scan_steps = [&](FitResult* fit) {
+    for (size_t p = 0; p < params_.size(); ++p) {
+      if (!IsStep(params_[p])) {
+        continue;
+      }
+      std::vector<double> x = fit->x;
+      double last = std::min(std::floor(upper[p]), double(duration_));
+      for (double step = std::ceil(lower[p]);
+           step <= last && fit->evaluations < max_evaluations; ++step) {
+        x[p] = step;
+        double value = Error(x);
+        ++fit->evaluations;
+        if (value < fit->error) {
+          fit->error = value;
+          fit->x = x;
+        }
+      }
+      fit->x[p] = std::lround(fit->x[p]);
+    }
+  };
+
+  // Restarts from the best point found, with a fresh simplex, as long as
+  // that helps: the plants' threshold behaviour gives the error flat
+  // stretches that a simplex can collapse on
+  FitResult best =
+      NelderMead(error, start, lower, upper, max_evaluations, tolerance);
+  scan_steps(&best);
+  while (best.evaluations < max_evaluations) {
+    FitResult next = NelderMead(error, best.x, lower, upper,
+                                max_evaluations - best.evaluations, tolerance);
+    next.evaluations += best.evaluations;
+    scan_steps(&next);
+    bool improved = next.error < best.error - tolerance;
+    if (next.error < best.error) {
+      best.x = next.x;
+      best.error = next.error;
+    }
+    best.evaluations = next.evaluations;
+    if (!improved) {
+      break;
+    }
+  }
+  return best;
+}
+
+}  // namespace tricycle
@@ -0,0 +1,113 @@
+#ifndef CYCLUS_TRICYCLE_CALIBRATION_H_
+#define CYCLUS_TRICYCLE_CALIBRATION_H_
+
+#include <functional>
+#include <istream>
+#include <string>
+#include <vector>
+
+#include "fuel_cycle_engine.h"
+
+namespace tricycle {
+
+/// Seconds in a year of twelve default time steps
+constexpr double kYearSeconds = 12 * kMonthSeconds;
+
+/// A digitized reference curve: global tritium inventory (kg) by year
+struct ReferenceCurve {
+  std::vector<double> years;
+  std::vector<double> tritium;
+};
+
+/// Reads a curve in the reference_data format: a "Year, Tritium [kg]"
+/// header, then one point per row in any order. Points are sorted by year.
+/// @throws std::invalid_argument on a malformed file
+ReferenceCurve ReadReferenceCurve(std::istream& in);
+
+/// Linear interpolation of ys over the increasing xs at x, held constant
+/// beyond the ends
+double Interpolate(const std::vector<double>& xs, const std::vector<double>& ys,
+                   double x);
+
+/// A parameter to fit and its bounds. Plant parameters are named as in
+/// FPPInput.csv, optionally prefixed by a prototype ("PlantOne.TBR") to fit
+/// one design only; market parameters stand in for the DecayStorage and its
+/// sources and sinks: initial_inventory, external_supply, supply_end, sales,
+/// throughput and capacity. supply_end is a whole time step: runs round it
+/// to the nearest one.
+struct FitParam {
+  std::string name;
+  double lower = 0;
+  double upper = 0;
+  /// Starting value, the middle of the bounds when NaN
+  double start = 0;
+};
+
+/// Parses NAME=LOWER:UPPER[:START]
+/// @throws std::invalid_argument on a malformed spec
+FitParam ParseFitParam(const std::string& spec);
+
+/// Minimum found by Nelder-Mead
+struct FitResult {
+  std::vector<double> x;
+  double error = 0;
+  int evaluations = 0;
+};
+
+/// Nelder-Mead simplex search for a minimum of f within the box
+/// [lower, upper], starting from start. Points are searched in coordinates
+/// scaled to the box and clamped to it. Stops after max_evaluations calls
+/// of f or once the values at the simplex's vertices lie within tolerance
+/// of each other.
+FitResult NelderMead(const std::function<double(const std::vector<double>&)>& f,
+                     const std::vector<double>& start,
+                     const std::vector<double>& lower,
+                     const std::vector<double>& upper, int max_evaluations,
+                     double tolerance);
+
+/// @class Calibration
+/// Fits plant and market parameters of a FuelCycleEngine run to a reference
+/// curve. Every evaluation runs the engine once, which takes milliseconds
+/// for the shipped scenarios, so thousands of evaluations are practical.
+class Calibration {
+ public:
+  /// start_year is the year the first time step starts at
+  /// @throws std::invalid_argument for an unknown parameter name
+  Calibration(const std::vector<PlantSpec>& specs,
+              const std::vector<Deployment>& deployments,
+              const SupplySpec& supply, int duration, double dt,
+              double start_year, const ReferenceCurve& reference,
+              const std::vector<FitParam>& params);
+
+  /// Root mean square difference (kg) between the global tritium inventory
+  /// of a run with parameter values x, interpolated to the reference years,
+  /// and the reference, over the reference points within the run
+  double Error(const std::vector<double>& x) const;
+
+  /// Fits the parameters. supply_end is searched over each whole time step
+  /// within its bounds rather than by the simplex, and returned rounded.
+  FitResult Fit(int max_evaluations = 5000, double tolerance = 1e-6) const;
+
+  /// Runs the engine with parameter values x
+  FuelCycleEngine Run(const std::vector<double>& x) const;
+
+  const std::vector<FitParam>& params() const { return params_; }
+
+ private:
+  /// Copies of the inputs with parameter values x applied
+  void Apply(const std::vector<double>& x, std::vector<PlantSpec>* specs,
+             SupplySpec* supply) const;
+
+  std::vector<PlantSpec> specs_;
+  std::vector<Deployment> deployments_;
+  SupplySpec supply_;
+  int duration_;
+  double dt_;
+  double start_year_;
+  ReferenceCurve reference_;
+  std::vector<FitParam> params_;
+};
+
+}  // namespace tricycle
+
+#endif  // CYCLUS_TRICYCLE_CALIBRATION_H_
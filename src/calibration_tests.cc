@@ -0,0 +1,184 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+#include "calibration.h"
+
+namespace tricycle {
+namespace {
+
+std::vector<PlantSpec> Specs() {
+  std::stringstream ss(
+      "name,fusion_power,TBR,reserve_inventory,sequestered_equilibrium\n"
+      "PlantOne,300,1.08,6.0,2.121\n");
+  return ReadPlantSpecs(ss);
+}
+
+std::vector<Deployment> Deploy() {
+  std::stringstream ss(
+      "region_name,institution,prototypes,build_times,lifetimes,n_build\n"
+      "OneRegion,FusionPower,PlantOne,24,-1,2\n");
+  return ReadDeployments(ss);
+}
+
+SupplySpec Supply() {
+  SupplySpec supply;
+  supply.initial_inventory = 18.5;
+  supply.external_supply = 0.15;
+  supply.supply_end = 60;
+  supply.sales = 0.01;
+  return supply;
+}
+
+// The global inventory of a run sampled yearly, as a reference curve
+ReferenceCurve Sample(const FuelCycleEngine& engine, double start_year) {
+  ReferenceCurve curve;
+  for (const StepRecord& rec : engine.records()) {
+    if ((rec.time + 1) % 12 == 0) {
+      curve.years.push_back(start_year + (rec.time + 1) / 12);
+      curve.tritium.push_back(TotalTritium(rec));
+    }
+  }
+  return curve;
+}
+
+}  // namespace
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+TEST(CalibrationTest, ReadReferenceCurve) {
+  std::stringstream ss(
+      "Year, Tritium [kg]\n"
+      "2004.5, 19.0\n"
+      "2002.9, 18.5\n"
+      "\n");
+  ReferenceCurve curve = ReadReferenceCurve(ss);
+  ASSERT_EQ(2, curve.years.size());
+  EXPECT_DOUBLE_EQ(2002.9, curve.years[0]);
+  EXPECT_DOUBLE_EQ(19.0, curve.tritium[1]);
+
+  std::stringstream bad("Year, Tritium [kg]\n2003 18.5\n");
+  EXPECT_THROW(ReadReferenceCurve(bad), std::invalid_argument);
+  std::stringstream empty("Year, Tritium [kg]\n");
+  EXPECT_THROW(ReadReferenceCurve(empty), std::invalid_argument);
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+TEST(CalibrationTest, Interpolate) {
+  std::vector<double> xs = {0, 1, 3};
+  std::vector<double> ys = {0, 2, 6};
+  EXPECT_DOUBLE_EQ(1, Interpolate(xs, ys, 0.5));
+  EXPECT_DOUBLE_EQ(5, Interpolate(xs, ys, 2.5));
+  EXPECT_DOUBLE_EQ(0, Interpolate(xs, ys, -1));
+  EXPECT_DOUBLE_EQ(6, Interpolate(xs, ys, 4));
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+TEST(CalibrationTest, ParseFitParam) {
+  FitParam param = ParseFitParam("PlantOne.TBR=1.0:1.2:1.1");
+  EXPECT_EQ("PlantOne.TBR", param.name);
+  EXPECT_DOUBLE_EQ(1.0, param.lower);
+  EXPECT_DOUBLE_EQ(1.2, param.upper);
+  EXPECT_DOUBLE_EQ(1.1, param.start);
+  EXPECT_TRUE(std::isnan(ParseFitParam("sales=0:1").start));
+
+  EXPECT_THROW(ParseFitParam("sales"), std::invalid_argument);
+  EXPECT_THROW(ParseFitParam("sales=1"), std::invalid_argument);
+  EXPECT_THROW(ParseFitParam("sales=1:x"), std::invalid_argument);
+  EXPECT_THROW(ParseFitParam("sales=1:0"), std::invalid_argument);
+
+  std::vector<FitParam> unknown = {ParseFitParam("color=0:1")};
+  EXPECT_THROW(Calibration(Specs(), Deploy(), Supply(), 12, kMonthSeconds,
+                           2003, ReferenceCurve(), unknown),
+               std::invalid_argument);
+  std::vector<FitParam> plant_market = {ParseFitParam("PlantOne.sales=0:1")};
+  EXPECT_THROW(Calibration(Specs(), Deploy(), Supply(), 12, kMonthSeconds,
+                           2003, ReferenceCurve(), plant_market),
+               std::invalid_argument);
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+TEST(CalibrationTest, SupplyEndAndSales) {
+  SupplySpec supply = Supply();
+  FuelCycleEngine engine(Specs(), std::vector<Deployment>(), supply, 72);
+  engine.Run();
+
+  // Without plants the market grows with the supply, net of sales and
+  // decay, until the supply ends and only shrinks afterwards
+  const std::vector<StepRecord>& recs = engine.records();
+  for (size_t t = 1; t < recs.size(); ++t) {
+    EXPECT_DOUBLE_EQ(supply.sales, recs[t].sold) << "at time " << t;
+    if (static_cast<int>(t) < supply.supply_end) {
+      EXPECT_LT(recs[t - 1].market, recs[t].market) << "at time " << t;
+    } else if (static_cast<int>(t) > supply.supply_end) {
+      EXPECT_GT(recs[t - 1].market, recs[t].market) << "at time " << t;
+    }
+  }
+
+  // Sales stop at what is left of the market after decay
+  supply.sales = 100;
+  supply.external_supply = 0;
+  FuelCycleEngine drained(Specs(), std::vector<Deployment>(), supply, 2);
+  drained.Run();
+  EXPECT_LT(supply.initial_inventory - 0.1, drained.records()[0].sold);
+  EXPECT_GT(supply.initial_inventory, drained.records()[0].sold);
+  EXPECT_DOUBLE_EQ(0, drained.records()[0].market);
+  EXPECT_DOUBLE_EQ(0, drained.records()[1].sold);
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+TEST(CalibrationTest, RecoversParameters) {
+  int duration = 120;
+  double start_year = 2003;
+  FuelCycleEngine truth(Specs(), Deploy(), Supply(), duration);
+  truth.Run();
+  ReferenceCurve reference = Sample(truth, start_year);
+
+  std::vector<FitParam> params = {ParseFitParam("external_supply=0.05:0.3"),
+                                  ParseFitParam("sales=0:0.05")};
+  Calibration calibration(Specs(), Deploy(), Supply(), duration,
+                          kMonthSeconds, start_year, reference, params);
+  EXPECT_NEAR(0, calibration.Error({0.15, 0.01}), 1e-12);
+  EXPECT_LT(0.1, calibration.Error({0.175, 0.025}));
+
+  FitResult fit = calibration.Fit(2000, 1e-12);
+  EXPECT_LT(fit.evaluations, 2000);
+  EXPECT_NEAR(0.15, fit.x[0], 1e-4);
+  EXPECT_NEAR(0.01, fit.x[1], 1e-4);
+  EXPECT_LT(fit.error, 1e-3);
+
+  // Fitted values always lie within the bounds
+  std::vector<FitParam> narrow = {ParseFitParam("external_supply=0.05:0.1")};
+  Calibration bounded(Specs(), Deploy(), Supply(), duration, kMonthSeconds,
+                      start_year, reference, narrow);
+  FitResult edge = bounded.Fit();
+  EXPECT_NEAR(0.1, edge.x[0], 1e-4);
+  EXPECT_LE(edge.x[0], 0.1);
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+TEST(CalibrationTest, FitsSupplyEndInWholeSteps) {
+  int duration = 120;
+  double start_year = 2003;
+  FuelCycleEngine truth(Specs(), Deploy(), Supply(), duration);
+  truth.Run();
+  ReferenceCurve reference = Sample(truth, start_year);
+
+  // Runs round supply_end, so the error is the same within half a step
+  std::vector<FitParam> params = {ParseFitParam("supply_end=30:100:90"),
+                                  ParseFitParam("external_supply=0.05:0.3")};
+  Calibration calibration(Specs(), Deploy(), Supply(), duration,
+                          kMonthSeconds, start_year, reference, params);
+  EXPECT_DOUBLE_EQ(calibration.Error({59.6, 0.15}),
+                   calibration.Error({60.4, 0.15}));
+
+  FitResult fit = calibration.Fit(2000, 1e-12);
+  EXPECT_DOUBLE_EQ(60, fit.x[0]);
+  EXPECT_NEAR(0.15, fit.x[1], 1e-4);
+  EXPECT_LT(fit.error, 1e-3);
+  EXPECT_DOUBLE_EQ(fit.error, calibration.Error(fit.x));
+}
+
+}  // namespace tricycle
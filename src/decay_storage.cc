@@ -2,17 +2,47 @@
 
 #include "decay_storage.h"
 
+#include <vector>
+
+#include "tritium_decay.h"
+
 namespace tricycle {
 
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 DecayStorage::DecayStorage(cyclus::Context* ctx) : cyclus::Facility(ctx) {
   // Required by DRE policies
-  fuel_tracker.Init({&tritium_storage}, cyclus::CY_LARGE_DOUBLE);
+  fuel_tracker.Init({&tritium_storage, &tritium_inbox},
+                    cyclus::CY_LARGE_DOUBLE);
+
+  lazy_decay = false;
+  decay_epoch = 0;
+  record_dre = false;
+  prune_exchange = false;
+  prune_threshold = 0;
+  min_shipment = 0;
+  shipment_quantize = 0;
+  consolidation_period = 1;
+  age_bins = 0;
+  age_bin_width = 1;
+  withdrawal_order = "fifo";
+  quiescent_mode = false;
+  vintage_time = 0;
+  vintage_phase = 0;
+  vintages_changed = false;
+  recorded_empty = true;
+  record_stride = 1;
+  record_tolerance = 0;
+  InitRecorder();
+  perf.Init(this);
+  dre.Init(this);
 
   bool is_bulk = true;
 
   tritium_storage = cyclus::toolkit::ResBuf<cyclus::Material>(is_bulk);
   helium_storage = cyclus::toolkit::ResBuf<cyclus::Material>(is_bulk);
+  tritium_inbox = cyclus::toolkit::ResBuf<cyclus::Material>(is_bulk);
+
+  storage_inventory.Init(&tritium_storage);
 }
 
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
@@ -20,42 +50,217 @@ DecayStorage::DecayStorage(cyclus::Context* ctx) : cyclus::Facility(ctx) {
 void DecayStorage::EnterNotify() {
   cyclus::Facility::EnterNotify(); // call base function first
   fuel_tracker.set_capacity(max_tritium_inventory);
-  buy_policy.Init(this, &tritium_storage, std::string("input"), &fuel_tracker, throughput).Set(incommod).Start();
-  sell_policy.Init(this, &tritium_storage, std::string("output")).Set(outcommod).Start();
+  InitRecorder();
+  // In lazy mode incoming tritium is held apart until the storage has been
+  // normalized, so that lots with different decay times are never merged.
+  cyclus::toolkit::ResBuf<cyclus::Material>* buy_buf =
+      lazy_decay ? &tritium_inbox : &tritium_storage;
+  buy_policy.Init(this, buy_buf, std::string("input"), &fuel_tracker, throughput).Set(incommod).Start();
+  sell_policy
+      .Init(this, &tritium_storage, std::string("output"),
+            cyclus::CY_LARGE_DOUBLE, false,
+            shipment_quantize > 0 ? shipment_quantize : -1)
+      .Set(outcommod)
+      .Start();
+  sell_policy.MinShipment(min_shipment);
+  if (prune_exchange) {
+    buy_policy.Prune(prune_threshold, [this]() {
+      return fuel_tracker.space() > prune_threshold;
+    });
+  }
+  if (prune_exchange || consolidation_period > 1) {
+    sell_policy.Prune(prune_threshold, [this]() { return ShipmentDue(); });
+  }
+  if (age_bins > 0) {
+    if (withdrawal_order != "fifo" && withdrawal_order != "lifo") {
+      throw cyclus::ValueError("withdrawal_order must be 'fifo' or 'lifo', not '" +
+                               withdrawal_order + "'");
+    }
+    // A restarted storage picks its bins up where they were saved
+    vintages.Init(age_bins, age_bin_width);
+    if (vintage_tritium.empty()) {
+      vintage_time = context()->time();
+    } else {
+      vintages.Restore(vintage_tritium, vintage_helium3, vintage_phase);
+    }
+    buy_policy.ObserveDeliveries([this](double qty) {
+      vintages.Deposit(qty);
+      vintages_changed = true;
+    });
+    sell_policy.ObserveShipments(
+        [this](double qty) { WithdrawVintages(qty); });
+  }
+  if (record_dre) {
+    buy_policy.Count(&dre, "input");
+    sell_policy.Count(&dre, "output");
+  }
+
+  // Offers must carry an up to date composition
+  sell_policy.Observe(outcommod, [this]() {
+    Normalize();
+    storage_inventory.Materialize();
+  });
 }
 
-void DecayStorage::RecordInventories() {
+bool DecayStorage::ShipmentDue() {
+  int age = context()->time() - enter_time();
+  if (consolidation_period > 1 && age % consolidation_period != 0) {
+    return false;
+  }
+  return !prune_exchange || tritium_storage.quantity() > prune_threshold;
+}
+
+void DecayStorage::WithdrawVintages(double qty) {
+  AgeBinnedInventory::Order order = withdrawal_order == "lifo"
+                                        ? AgeBinnedInventory::kLifo
+                                        : AgeBinnedInventory::kFifo;
+  double mean_age;
+  double taken = vintages.Withdraw(qty, order, &mean_age);
+  vintages_changed = true;
   context()
-      ->NewDatum("StorageInventories")
+      ->NewDatum("StorageWithdrawals")
       ->AddVal("AgentId", id())
       ->AddVal("Time", context()->time())
-      ->AddVal("TritiumStorage", tritium_storage.quantity())
-      ->AddVal("HeliumStorage", helium_storage.quantity())
+      ->AddVal("Quantity", taken)
+      ->AddVal("MeanAge", mean_age)
       ->Record();
 }
 
-void DecayStorage::ExtractHelium() {
-  if (!tritium_storage.empty()) {
-    cyclus::Material::Ptr mat = tritium_storage.Pop();
-    cyclus::toolkit::MatQuery mq(mat);
-    
-    cyclus::Material::Ptr helium = mat->ExtractComp(mq.mass(He3_id), He3_comp);
+void DecayStorage::RecordAgeBins() {
+  // Decay alone follows from the last rows, so the bins are only written
+  // when something else changed them, and on the last time step
+  cyclus::Context* ctx = context();
+  bool last_step = ctx->time() >= ctx->sim_info().duration - 1;
+  if (vintages_changed || last_step) {
+    WriteAgeBins();
+  }
+  vintages_changed = false;
+  vintages.Save(&vintage_tritium, &vintage_helium3, &vintage_phase);
+}
+
+void DecayStorage::WriteAgeBins() {
+  for (size_t i = 0; i < vintages.size(); ++i) {
+    if (vintages.tritium(i) <= 0) {
+      continue;
+    }
+    context()
+        ->NewDatum("StorageAgeBins")
+        ->AddVal("AgentId", id())
+        ->AddVal("Time", context()->time())
+        ->AddVal("Bin", static_cast<int>(i))
+        ->AddVal("MeanAge", vintages.age(i))
+        ->AddVal("Tritium", vintages.tritium(i))
+        ->AddVal("Helium3", vintages.helium3(i))
+        ->Record();
+  }
+}
+
+void DecayStorage::InitRecorder() {
+  recorder.Init(this, "StorageInventories", {"TritiumStorage", "HeliumStorage"},
+                record_stride, record_tolerance);
+}
+
+void DecayStorage::RecordInventories() {
+  storage_inventory.Sync();
+  double pending_helium = lazy_decay ? PendingHelium() : 0.0;
 
+  // The storage running dry or being refilled is always recorded
+  bool empty = storage_inventory.ledger().empty();
+  bool transition = (empty != recorded_empty);
+  recorded_empty = empty;
+
+  recorder.Record({storage_inventory.quantity() - pending_helium,
+                   helium_storage.quantity() + pending_helium},
+                  transition);
+}
+
+void DecayStorage::Decommission() {
+  TRICYCLE_PERF_FLUSH(perf);
+  cyclus::Facility::Decommission();
+}
+
+double DecayStorage::PendingHelium() {
+  if (context()->sim_info().decay == "never") {
+    return 0.0;
+  }
+  int dt = context()->time() - decay_epoch;
+  return storage_inventory.tritium() *
+         (1 - TritiumSurvivingFraction(dt * context()->dt()));
+}
+
+void DecayStorage::Normalize() {
+  storage_inventory.Sync();
+  if (decay_epoch == context()->time()) {
+    return;
+  }
+  if (context()->sim_info().decay != "never") {
+    storage_inventory.Decay(context()->time() - decay_epoch, context()->dt());
+  }
+  ExtractHelium();
+  decay_epoch = context()->time();
+}
+
+void DecayStorage::ExtractHelium() {
+  cyclus::Material::Ptr helium = storage_inventory.ExtractHelium3();
+  if (helium) {
     helium_storage.Push(helium);
-    tritium_storage.Push(mat);
-  };
+  }
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+bool DecayStorage::Idle() {
+  return quiescent_mode && tritium_storage.empty() && tritium_inbox.empty();
 }
 
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 void DecayStorage::Tick() {
-  tritium_storage.Decay();
-  ExtractHelium();
+  TRICYCLE_PERF_SCOPE(perf, "Tick");
+  if (age_bins > 0) {
+    int dt = context()->time() - vintage_time;
+    if (dt > 0 && context()->sim_info().decay != "never") {
+      vintages.Decay(TritiumSurvivingFraction(dt * context()->dt()));
+    }
+    for (; vintage_time < context()->time(); ++vintage_time) {
+      vintages_changed |= vintages.Advance();
+    }
+  }
+  if (Idle()) {
+    // Nothing to decay; keep the epoch current so that waking up costs
+    // nothing either
+    decay_epoch = context()->time();
+  } else if (!lazy_decay) {
+    Normalize();
+    // Trades may be pushed straight into tritium_storage
+    storage_inventory.Materialize();
+  }
   LOG(cyclus::LEV_INFO2, "Storage") << "Quantity to be offered: " << throughput << " kg.";
 }
 
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 void DecayStorage::Tock() {
-  RecordInventories();
+  {
+    TRICYCLE_PERF_SCOPE(perf, "Tock");
+    if (!tritium_inbox.empty()) {
+      Normalize();
+      std::vector<cyclus::Material::Ptr> received =
+          tritium_inbox.PopN(tritium_inbox.count());
+      for (size_t i = 0; i < received.size(); ++i) {
+        storage_inventory.Push(received[i]);
+      }
+    }
+    // An empty storage has nothing new to record until it is filled, apart
+    // from on the last time step
+    cyclus::Context* ctx = context();
+    if (!(Idle() && recorded_empty) ||
+        ctx->time() >= ctx->sim_info().duration - 1) {
+      RecordInventories();
+    }
+    if (age_bins > 0) {
+      RecordAgeBins();
+    }
+    dre.Record();
+  }
+  TRICYCLE_PERF_END_STEP(perf);
 }
 
 // WARNING! Do not change the following this function!!! This enables your
@@ -6,6 +6,11 @@
 #include "cyclus.h"
 
 #include "boost/shared_ptr.hpp"
+#include "age_binned_inventory.h"
+#include "inventory_recorder.h"
+#include "observed_policies.h"
+#include "perf_timer.h"
+#include "tritium_buffer.h"
 
 #pragma cyclus exec from cyclus.system import CY_LARGE_DOUBLE, CY_LARGE_INT, CY_NEAR_ZERO
 
@@ -38,6 +43,13 @@ namespace tricycle {
 /// The tritium_storage buffer uses bulk storage mode for automatic material
 /// combining, and helium-3 is continuously separated and stored independently
 /// as a byproduct (not currently offered to market).
+///
+/// With lazy_decay enabled the storage is instead kept normalized to a
+/// reference epoch (decay_epoch) and Tick does no work. Decay and helium-3
+/// extraction are only applied when the inventory is observed: when the sell
+/// policy bids against actual demand, or when an incoming trade has to be
+/// merged in Tock. Recorded inventories are computed analytically from the
+/// epoch values.
 class DecayStorage : public cyclus::Facility {
  public:
   /// Constructor for DecayStorage Class
@@ -59,16 +71,38 @@ class DecayStorage : public cyclus::Facility {
   /// Transfers incoming material to storage and records inventories
   virtual void Tock();
 
+  /// Writes the phase timers (TRICYCLE_PERF builds only)
+  virtual void Decommission();
+
  protected:
   /// Extracts helium-3 byproduct from decayed tritium and stores it separately
   void ExtractHelium();
   
+  /// Applies the configured recording policy to StorageInventories
+  void InitRecorder();
+
   /// Records current tritium and helium-3 inventory quantities
   void RecordInventories();
 
-  const int He3_id = 20030000;
-  const cyclus::CompMap He3 = {{He3_id, 1}};
-  const cyclus::Composition::Ptr He3_comp = cyclus::Composition::CreateFromAtom(He3);
+  /// Brings tritium_storage from decay_epoch up to the current time and
+  /// extracts the helium-3 that grew in the meantime
+  void Normalize();
+
+  /// Mass of helium-3 grown in tritium_storage since decay_epoch
+  double PendingHelium();
+
+  /// Whether offers are made this time step
+  bool ShipmentDue();
+
+  /// Whether quiescent_mode lets this time step be skipped
+  bool Idle();
+
+  /// Books a shipment against the age bins and records its mean age
+  void WithdrawVintages(double qty);
+
+  /// Writes the age bins to StorageAgeBins if they changed, and saves them
+  void RecordAgeBins();
+  void WriteAgeBins();
 
   // --- Module Members ---
   #pragma cyclus var {"tooltip": "Tritium input commodity",\
@@ -103,23 +137,208 @@ class DecayStorage : public cyclus::Facility {
                       "units":"kg"}
   double max_tritium_inventory;
 
+  #pragma cyclus var {"default": False,\
+                      "tooltip":"Only apply decay when inventory is observed",\
+                      "doc":"If true, decay and helium-3 extraction are deferred "\
+                      "until the inventory is traded or bid on, instead of "\
+                      "being applied every time step",\
+                      "uilabel":"Lazy Decay"}
+  bool lazy_decay;
+
+  #pragma cyclus var {"default": 0,\
+                      "internal": True,\
+                      "tooltip":"Time tritium_storage was last normalized",\
+                      "doc":"Reference epoch of tritium_storage in lazy decay "\
+                      "mode (internal state)",\
+                      "uilabel":"Decay Epoch"}
+  int decay_epoch;
+
+  #pragma cyclus var {"default": 1,\
+                      "tooltip":"Time steps between inventory records",\
+                      "doc":"Inventories are only recorded every record_stride "\
+                      "time steps (the storage emptying or filling and the "\
+                      "last time step are always recorded)",\
+                      "uilabel":"Inventory Record Stride",\
+                      "units":"Timesteps"}
+  int record_stride;
+
+  #pragma cyclus var {"default": 0.0,\
+                      "tooltip":"Relative deadband for inventory records",\
+                      "doc":"Relative change an inventory must exceed since the "\
+                      "last record for a new record to be written. 0 records "\
+                      "unconditionally.",\
+                      "uilabel":"Inventory Record Tolerance"}
+  double record_tolerance;
+
+  #pragma cyclus var {"default": False,\
+                      "tooltip":"Record exchange traffic per policy",\
+                      "doc":"If true, the requests, bids and trades of the "\
+                      "buy and sell policies are counted and written to the "\
+                      "DreTraffic table every time step",\
+                      "uilabel":"Record DRE Traffic"}
+  bool record_dre;
+
+  #pragma cyclus var {"default": False,\
+                      "tooltip":"Suppress idle requests and bids",\
+                      "doc":"If true, tritium is only requested while the "\
+                      "storage has more than prune_threshold of room left, "\
+                      "and only offered while it holds more than "\
+                      "prune_threshold",\
+                      "uilabel":"Prune Exchange"}
+  bool prune_exchange;
+
+  #pragma cyclus var {"default": 0.0,\
+                      "tooltip":"Smallest quantity posted when pruning",\
+                      "doc":"Smallest request or offer posted in "\
+                      "prune_exchange mode",\
+                      "uilabel":"Prune Threshold",\
+                      "uitype": "range", \
+                      "range": [0.0, CY_LARGE_DOUBLE], \
+                      "units":"kg"}
+  double prune_threshold;
+
+  #pragma cyclus var {"default": 0.0,\
+                      "tooltip":"Smallest shipment offered (kg)",\
+                      "doc":"Requests that could only be filled with less "\
+                      "than min_shipment are not bid on",\
+                      "uilabel":"Minimum Shipment",\
+                      "uitype": "range", \
+                      "range": [0.0, CY_LARGE_DOUBLE], \
+                      "units":"kg"}
+  double min_shipment;
+
+  #pragma cyclus var {"default": 0.0,\
+                      "tooltip":"Shipment size quantum (kg)",\
+                      "doc":"If positive, offers are made in whole multiples "\
+                      "of shipment_quantize",\
+                      "uilabel":"Shipment Quantize",\
+                      "uitype": "range", \
+                      "range": [0.0, CY_LARGE_DOUBLE], \
+                      "units":"kg"}
+  double shipment_quantize;
+
+  #pragma cyclus var {"default": 1,\
+                      "tooltip":"Time steps between shipments",\
+                      "doc":"Tritium is only offered every "\
+                      "consolidation_period time steps after the storage is "\
+                      "deployed, so that demand building up in between is "\
+                      "shipped at once",\
+                      "uilabel":"Consolidation Period",\
+                      "units":"Timesteps"}
+  int consolidation_period;
+
+  #pragma cyclus var {"default": 0,\
+                      "tooltip":"Number of inventory age bins",\
+                      "doc":"If positive, the stored tritium is also tracked "\
+                      "by age in this many bins of age_bin_width time steps "\
+                      "each, and its age distribution is written to the "\
+                      "StorageAgeBins table. 0 disables age tracking.",\
+                      "uilabel":"Age Bins"}
+  int age_bins;
+
+  #pragma cyclus var {"default": 1,\
+                      "tooltip":"Time steps per age bin",\
+                      "doc":"Width of each inventory age bin",\
+                      "uilabel":"Age Bin Width",\
+                      "units":"Timesteps"}
+  int age_bin_width;
+
+  #pragma cyclus var {"default": "fifo",\
+                      "tooltip":"Order tritium is shipped in ('fifo' or 'lifo')",\
+                      "doc":"Whether shipments are taken from the oldest "\
+                      "('fifo') or youngest ('lifo') age bins first",\
+                      "uitype": "combobox",\
+                      "categorical": ["fifo", "lifo"],\
+                      "uilabel":"Withdrawal Order"}
+  std::string withdrawal_order;
+
+  #pragma cyclus var {"default": False,\
+                      "tooltip":"Skip idle time steps while empty",\
+                      "doc":"If true, an empty storage with nothing received "\
+                      "skips decay and only records its inventories when "\
+                      "it is filled or on the last time step",\
+                      "uilabel":"Quiescent Mode"}
+  bool quiescent_mode;
+
   #pragma cyclus var {"tooltip":"Bulk storage buffer for tritium inventory with decay"}
   cyclus::toolkit::ResBuf<cyclus::Material> tritium_storage;
 
   #pragma cyclus var {"tooltip":"Bulk storage buffer for extracted helium-3 byproduct"}
   cyclus::toolkit::ResBuf<cyclus::Material> helium_storage;
 
+  #pragma cyclus var {"tooltip":"Buffer for tritium received in lazy decay mode"}
+  cyclus::toolkit::ResBuf<cyclus::Material> tritium_inbox;
+
   /// Required to make the matl_buy/sell_policy work
   #pragma cyclus var {"tooltip":"Tracker to handle on-hand tritium"}
   cyclus::toolkit::TotalInvTracker fuel_tracker;
 
   /// Policy for requesting tritium material
-  cyclus::toolkit::MatlBuyPolicy buy_policy;
+  ObservedBuyPolicy buy_policy;
 
   /// Policy for offering tritium material
-  cyclus::toolkit::MatlSellPolicy sell_policy;
+  ObservedSellPolicy sell_policy;
+
+  /// Nuclide ledger kept in step with tritium_storage
+  TritiumBuffer storage_inventory;
+
+  /// Writes StorageInventories
+  InventoryRecorder recorder;
+
+  #pragma cyclus var {"default": True,\
+                      "internal": True,\
+                      "tooltip":"Whether the storage was empty when last recorded",\
+                      "doc":"Whether the storage was empty when its inventories "\
+                      "were last recorded (internal state)",\
+                      "uilabel":"Recorded Empty"}
+  bool recorded_empty;
+
+  /// Tritium inventory by age, when age_bins is set, and whether anything
+  /// but decay changed it this time step
+  AgeBinnedInventory vintages;
+  bool vintages_changed;
+
+  // The age bins are saved at the end of every time step
+  #pragma cyclus var {"default": [],\
+                      "internal": True,\
+                      "tooltip":"Tritium by age bin (kg)",\
+                      "doc":"Tritium of each age bin, youngest first "\
+                      "(internal state)",\
+                      "uilabel":"Age Bin Tritium"}
+  std::vector<double> vintage_tritium;
+
+  #pragma cyclus var {"default": [],\
+                      "internal": True,\
+                      "tooltip":"Helium-3 grown by age bin (kg)",\
+                      "doc":"Helium-3 grown in each age bin, youngest first "\
+                      "(internal state)",\
+                      "uilabel":"Age Bin Helium-3"}
+  std::vector<double> vintage_helium3;
+
+  #pragma cyclus var {"default": 0,\
+                      "internal": True,\
+                      "tooltip":"Time steps since the youngest age bin opened",\
+                      "doc":"Time steps since the youngest age bin was opened "\
+                      "(internal state)",\
+                      "uilabel":"Age Bin Phase"}
+  int vintage_phase;
+
+  #pragma cyclus var {"default": 0,\
+                      "internal": True,\
+                      "tooltip":"Time the age bins were last decayed",\
+                      "doc":"Time the age bins were last decayed and aged "\
+                      "(internal state)",\
+                      "uilabel":"Age Bin Time"}
+  int vintage_time;
+
+  /// Time spent in Tick and Tock (TRICYCLE_PERF builds only)
+  PerfLog perf;
+
+  /// Exchange traffic of the policies, when record_dre is set
+  DreCounter dre;
 
   friend class DecayStorageTest;
+  friend class DecayStorageBench;
 
   // And away we go!
 };
@@ -1,5 +1,6 @@
 #include <gtest/gtest.h>
 
+#include <algorithm>
 #include <cmath>
 
 
@@ -231,6 +232,209 @@ TEST_F(DecayStorageTest, ExtractHeliumEmptyStorage) {
   ExtractEmptyHeliumTest();
 }
 
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+TEST_F(DecayStorageTest, LazyDecayMatchesEager) {
+  // Test that deferring decay to the points where inventory is observed
+  // records the same inventories as decaying every time step.
+
+  std::string config =
+      " <incommod>Tritium</incommod>"
+      " <outcommod>Tritium_Out</outcommod>"
+      " <throughput>10</throughput>"
+      " <max_tritium_inventory>100</max_tritium_inventory>";
+
+  int simdur = 4;
+  cyclus::MockSim eager_sim = InitializeSim(config, simdur);
+  eager_sim.Run();
+
+  cyclus::MockSim lazy_sim =
+      InitializeSim(config + " <lazy_decay>1</lazy_decay>", simdur);
+  lazy_sim.Run();
+
+  for (int t = 1; t < simdur; ++t) {
+    QueryResult qr_eager = TimeInventoryQuery(eager_sim, std::to_string(t));
+    QueryResult qr_lazy = TimeInventoryQuery(lazy_sim, std::to_string(t));
+
+    EXPECT_NEAR(qr_eager.GetVal<double>("TritiumStorage"),
+                qr_lazy.GetVal<double>("TritiumStorage"), 1e-9);
+    EXPECT_NEAR(qr_eager.GetVal<double>("HeliumStorage"),
+                qr_lazy.GetVal<double>("HeliumStorage"), 1e-9);
+  }
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+TEST_F(DecayStorageTest, LazyDecayIdleStorage) {
+  // An idle storage in lazy mode still reports the helium-3 that has grown
+  // since its last normalization.
+
+  std::string config = common_config + " <lazy_decay>1</lazy_decay>";
+
+  int simdur = 3;
+  cyclus::MockSim sim = InitializeSim(config, simdur);
+  sim.Run();
+
+  QueryResult qr_1 = TimeInventoryQuery(sim, "1");
+  QueryResult qr_2 = TimeInventoryQuery(sim, "2");
+
+  EXPECT_LT(0.0, qr_1.GetVal<double>("HeliumStorage"));
+  EXPECT_LT(qr_1.GetVal<double>("HeliumStorage"),
+            qr_2.GetVal<double>("HeliumStorage"));
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+TEST_F(DecayStorageTest, DreTraffic) {
+  // The storage fills up with its first request, and nobody asks for its
+  // output, so only the input policy shows up, and only once.
+
+  std::string config = common_config + " <record_dre>1</record_dre>";
+
+  int simdur = 3;
+  cyclus::MockSim sim = InitializeSim(config, simdur);
+  sim.Run();
+
+  QueryResult qr = sim.db().Query("DreTraffic", NULL);
+  ASSERT_EQ(1, qr.rows.size());
+  EXPECT_EQ(0, qr.GetVal<int>("Time"));
+  EXPECT_EQ("input", qr.GetVal<std::string>("Policy"));
+  EXPECT_EQ(1, qr.GetVal<int>("Requests"));
+  EXPECT_EQ(0, qr.GetVal<int>("PrunedRequests"));
+  EXPECT_EQ(0, qr.GetVal<int>("Unfulfilled"));
+  EXPECT_EQ(0, qr.GetVal<int>("Bids"));
+  EXPECT_EQ(1, qr.GetVal<int>("Trades"));
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+TEST_F(DecayStorageTest, PruneExchange) {
+  // Filling up 3 kg at a time, a pruned storage stops requesting once it
+  // has less than 5 kg of room left, instead of topping up the last few kg,
+  // and counts the requests it withholds.
+
+  std::string config =
+      " <incommod>Tritium</incommod>"
+      " <outcommod>Tritium_Out</outcommod>"
+      " <throughput>3</throughput>"
+      " <max_tritium_inventory>10</max_tritium_inventory>"
+      " <record_dre>1</record_dre>";
+  std::string pruned = " <prune_exchange>1</prune_exchange>"
+                       " <prune_threshold>5</prune_threshold>";
+
+  int simdur = 5;
+  cyclus::MockSim full_sim = InitializeSim(config, simdur);
+  full_sim.Run();
+  cyclus::MockSim pruned_sim = InitializeSim(config + pruned, simdur);
+  pruned_sim.Run();
+
+  std::vector<Cond> conds;
+  conds.push_back(Cond("Policy", "==", std::string("input")));
+  QueryResult full = full_sim.db().Query("DreTraffic", &conds);
+  EXPECT_LE(4, full.rows.size());
+  conds.push_back(Cond("Requests", ">", 0));
+  QueryResult qr = pruned_sim.db().Query("DreTraffic", &conds);
+  ASSERT_EQ(2, qr.rows.size());
+  conds.back() = Cond("PrunedRequests", ">", 0);
+  EXPECT_EQ(3, pruned_sim.db().Query("DreTraffic", &conds).rows.size());
+
+  QueryResult last = TimeInventoryQuery(pruned_sim, "4");
+  EXPECT_NEAR(6.0, last.GetVal<double>("TritiumStorage") +
+                       last.GetVal<double>("HeliumStorage"), 1e-9);
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+TEST_F(DecayStorageTest, ShipmentConsolidation) {
+  // Offers are only made every consolidation_period time steps, and never
+  // for less than min_shipment.
+
+  int simdur = 8;
+  std::vector<Cond> conds;
+  conds.push_back(Cond("Commodity", "==", std::string("Tritium_Out")));
+
+  cyclus::MockSim every_sim = InitializeSim(common_config, simdur);
+  every_sim.AddSink("Tritium_Out").capacity(1).Finalize();
+  every_sim.Run();
+  EXPECT_EQ(7, every_sim.db().Query("Transactions", &conds).rows.size());
+
+  std::string config =
+      common_config + " <consolidation_period>3</consolidation_period>";
+  cyclus::MockSim periodic_sim = InitializeSim(config, simdur);
+  periodic_sim.AddSink("Tritium_Out").capacity(1).Finalize();
+  periodic_sim.Run();
+  QueryResult qr = periodic_sim.db().Query("Transactions", &conds);
+  ASSERT_EQ(2, qr.rows.size());
+  EXPECT_EQ(0, qr.GetVal<int>("Time", 0) % 3);
+  EXPECT_EQ(0, qr.GetVal<int>("Time", 1) % 3);
+
+  config = common_config + " <min_shipment>1.5</min_shipment>";
+  cyclus::MockSim min_sim = InitializeSim(config, simdur);
+  min_sim.AddSink("Tritium_Out").capacity(1).Finalize();
+  min_sim.Run();
+  EXPECT_EQ(0, min_sim.db().Query("Transactions", &conds).rows.size());
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+TEST_F(DecayStorageTest, AgeBins) {
+  // The tritium bought at time 0 ages one bin per time step, and is what
+  // gets shipped.
+
+  std::string config = common_config + " <age_bins>3</age_bins>";
+
+  int simdur = 4;
+  cyclus::MockSim sim = InitializeSim(config, simdur);
+  sim.AddSink("Tritium_Out").capacity(1).Finalize();
+  sim.Run();
+
+  std::vector<Cond> conds;
+  conds.push_back(Cond("Time", "==", std::string("2")));
+  QueryResult shipped = sim.db().Query("StorageWithdrawals", &conds);
+  EXPECT_NEAR(1.0, shipped.GetVal<double>("Quantity"), 1e-6);
+  EXPECT_DOUBLE_EQ(2.0, shipped.GetVal<double>("MeanAge"));
+
+  QueryResult bins = sim.db().Query("StorageAgeBins", &conds);
+  ASSERT_EQ(1, bins.rows.size());
+  EXPECT_EQ(2, bins.GetVal<int>("Bin"));
+  EXPECT_LT(0.0, bins.GetVal<double>("Helium3"));
+
+  // Bins that only decay are written when filled and on the last time step
+  std::string still = common_config +
+                      " <age_bins>3</age_bins>"
+                      " <age_bin_width>10</age_bin_width>"
+                      " <prune_exchange>1</prune_exchange>"
+                      " <prune_threshold>1</prune_threshold>";
+  cyclus::MockSim still_sim = InitializeSim(still, simdur);
+  still_sim.Run();
+  QueryResult rows = still_sim.db().Query("StorageAgeBins", NULL);
+  std::vector<int> times;
+  for (size_t i = 0; i < rows.rows.size(); ++i) {
+    times.push_back(rows.GetVal<int>("Time", i));
+  }
+  std::sort(times.begin(), times.end());
+  std::vector<int> expected = {0, simdur - 1};
+  EXPECT_EQ(expected, times);
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+TEST_F(DecayStorageTest, Quiescent) {
+  // With nothing to buy, a quiescent storage stays empty and only records
+  // its inventories on the last time step.
+
+  std::string config = common_config + " <quiescent_mode>1</quiescent_mode>";
+
+  int simdur = 5;
+  cyclus::MockSim sim(cyclus::AgentSpec(":tricycle:DecayStorage"), config,
+                      simdur);
+  sim.Run();
+
+  QueryResult qr = sim.db().Query("StorageInventories", NULL);
+  ASSERT_EQ(1, qr.rows.size());
+  EXPECT_EQ(simdur - 1, qr.GetVal<int>("Time"));
+  EXPECT_DOUBLE_EQ(0.0, qr.GetVal<double>("TritiumStorage"));
+
+  // Once filled it records as before
+  cyclus::MockSim filled_sim = InitializeSim(config, simdur);
+  filled_sim.Run();
+  EXPECT_EQ(simdur,
+            filled_sim.db().Query("StorageInventories", NULL).rows.size());
+}
+
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 TEST_F(DecayStorageTest, EnterNotifyPolicySetup) {
   // Test that EnterNotify sets up buy and sell policies correctly
@@ -0,0 +1,87 @@
+// dre_counter.cc
+
+#include "dre_counter.h"
+
+namespace tricycle {
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+DreCounter::DreCounter() : agent_(NULL) {}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void DreCounter::Init(cyclus::Agent* agent) {
+  agent_ = agent;
+  counts_.clear();
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void DreCounter::Requests(
+    const std::string& policy,
+    const std::set<cyclus::RequestPortfolio<cyclus::Material>::Ptr>& ports,
+    int pruned) {
+  Counts& c = counts_[policy];
+  std::set<cyclus::RequestPortfolio<cyclus::Material>::Ptr>::const_iterator it;
+  for (it = ports.begin(); it != ports.end(); ++it) {
+    c.requests += (*it)->requests().size();
+  }
+  c.pruned_requests += pruned;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void DreCounter::Bids(
+    const std::string& policy,
+    const std::set<cyclus::BidPortfolio<cyclus::Material>::Ptr>& ports) {
+  Counts& c = counts_[policy];
+  std::set<cyclus::BidPortfolio<cyclus::Material>::Ptr>::const_iterator it;
+  for (it = ports.begin(); it != ports.end(); ++it) {
+    c.bids += (*it)->bids().size();
+  }
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void DreCounter::Sold(
+    const std::string& policy,
+    const std::vector<cyclus::Trade<cyclus::Material> >& trades) {
+  counts_[policy].trades += trades.size();
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void DreCounter::Bought(
+    const std::string& policy,
+    const std::vector<std::pair<cyclus::Trade<cyclus::Material>,
+                                cyclus::Material::Ptr> >& responses) {
+  Counts& c = counts_[policy];
+  c.trades += responses.size();
+
+  // One request can be filled by several bids
+  std::set<cyclus::Request<cyclus::Material>*> matched;
+  for (size_t i = 0; i < responses.size(); ++i) {
+    matched.insert(responses[i].first.request);
+  }
+  c.matched += matched.size();
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void DreCounter::Record() {
+  std::map<std::string, Counts>::iterator it;
+  for (it = counts_.begin(); it != counts_.end(); ++it) {
+    const Counts& c = it->second;
+    if (c.requests == 0 && c.pruned_requests == 0 && c.bids == 0 &&
+        c.trades == 0) {
+      continue;
+    }
+    agent_->context()
+        ->NewDatum("DreTraffic")
+        ->AddVal("AgentId", agent_->id())
+        ->AddVal("Time", agent_->context()->time())
+        ->AddVal("Policy", it->first)
+        ->AddVal("Requests", c.requests)
+        ->AddVal("PrunedRequests", c.pruned_requests)
+        ->AddVal("Unfulfilled", c.requests - c.matched)
+        ->AddVal("Bids", c.bids)
+        ->AddVal("Trades", c.trades)
+        ->Record();
+  }
+  counts_.clear();
+}
+
+}  // namespace tricycle
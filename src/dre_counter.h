@@ -0,0 +1,74 @@
+#ifndef CYCLUS_TRICYCLE_DRE_COUNTER_H_
+#define CYCLUS_TRICYCLE_DRE_COUNTER_H_
+
+#include <map>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "cyclus.h"
+
+namespace tricycle {
+
+/// @class DreCounter
+/// Counts the exchange traffic each of an agent's policies generates in a
+/// time step, and writes it to the DreTraffic table:
+///  - AgentId, Time, Policy
+///  - Requests: requests issued
+///  - PrunedRequests: requests the policy withheld in prune_exchange mode,
+///    because its gate was closed or they asked for too little
+///  - Unfulfilled: requests issued that were not matched by any trade
+///  - Bids: bids issued
+///  - Trades: trades matched, as buyer or seller
+///
+/// Only policies that took part in the exchange, or withheld requests from
+/// it, get a row.
+class DreCounter {
+ public:
+  DreCounter();
+
+  void Init(cyclus::Agent* agent);
+
+  /// Counts the requests of policy, and the pruned ones it withheld
+  void Requests(const std::string& policy,
+                const std::set<cyclus::RequestPortfolio<cyclus::Material>::Ptr>&
+                    ports,
+                int pruned = 0);
+
+  /// Counts the bids of policy
+  void Bids(const std::string& policy,
+            const std::set<cyclus::BidPortfolio<cyclus::Material>::Ptr>&
+                ports);
+
+  /// Counts the trades policy fills as a seller
+  void Sold(const std::string& policy,
+            const std::vector<cyclus::Trade<cyclus::Material> >& trades);
+
+  /// Counts the trades policy accepts as a buyer
+  void Bought(const std::string& policy,
+              const std::vector<std::pair<cyclus::Trade<cyclus::Material>,
+                                          cyclus::Material::Ptr> >& responses);
+
+  /// Writes the counts of the current time step and starts over
+  void Record();
+
+ private:
+  struct Counts {
+    Counts()
+        : requests(0), pruned_requests(0), matched(0), bids(0), trades(0) {}
+    int requests;
+    int pruned_requests;
+    /// Requests matched by at least one trade
+    int matched;
+    int bids;
+    int trades;
+  };
+
+  cyclus::Agent* agent_;
+  std::map<std::string, Counts> counts_;
+};
+
+}  // namespace tricycle
+
+#endif  // CYCLUS_TRICYCLE_DRE_COUNTER_H_
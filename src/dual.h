@@ -0,0 +1,153 @@
+#ifndef CYCLUS_TRICYCLE_DUAL_H_
+#define CYCLUS_TRICYCLE_DUAL_H_
+
+#include <cmath>
+
+// Forward-mode automatic differentiation with dual numbers: a value carried
+// together with its derivatives with respect to N parameters. Arithmetic on
+// duals applies the chain rule, so any kernel templated on its number type
+// gives derivatives alongside values from a single evaluation. Comparisons
+// only look at the values, so branches follow the plain double computation.
+// Nothing in here depends on cyclus.
+
+namespace tricycle {
+
+template <int N>
+struct Dual {
+  double v;
+  double d[N];
+
+  Dual(double value = 0) : v(value) {
+    for (int i = 0; i < N; ++i) {
+      d[i] = 0;
+    }
+  }
+
+  /// The value of parameter i, whose derivative with respect to itself is 1
+  static Dual Variable(double value, int i) {
+    Dual x(value);
+    x.d[i] = 1;
+    return x;
+  }
+
+  Dual& operator+=(const Dual& y) {
+    v += y.v;
+    for (int i = 0; i < N; ++i) {
+      d[i] += y.d[i];
+    }
+    return *this;
+  }
+
+  Dual& operator-=(const Dual& y) {
+    v -= y.v;
+    for (int i = 0; i < N; ++i) {
+      d[i] -= y.d[i];
+    }
+    return *this;
+  }
+
+  Dual& operator*=(const Dual& y) {
+    for (int i = 0; i < N; ++i) {
+      d[i] = d[i] * y.v + v * y.d[i];
+    }
+    v *= y.v;
+    return *this;
+  }
+
+  Dual& operator/=(const Dual& y) {
+    for (int i = 0; i < N; ++i) {
+      d[i] = (d[i] * y.v - v * y.d[i]) / (y.v * y.v);
+    }
+    v /= y.v;
+    return *this;
+  }
+};
+
+template <int N>
+Dual<N> operator-(Dual<N> x) {
+  x.v = -x.v;
+  for (int i = 0; i < N; ++i) {
+    x.d[i] = -x.d[i];
+  }
+  return x;
+}
+
+template <int N>
+Dual<N> operator+(Dual<N> x, const Dual<N>& y) {
+  return x += y;
+}
+template <int N>
+Dual<N> operator+(Dual<N> x, double y) {
+  return x += Dual<N>(y);
+}
+template <int N>
+Dual<N> operator+(double x, const Dual<N>& y) {
+  return Dual<N>(x) += y;
+}
+
+template <int N>
+Dual<N> operator-(Dual<N> x, const Dual<N>& y) {
+  return x -= y;
+}
+template <int N>
+Dual<N> operator-(Dual<N> x, double y) {
+  return x -= Dual<N>(y);
+}
+template <int N>
+Dual<N> operator-(double x, const Dual<N>& y) {
+  return Dual<N>(x) -= y;
+}
+
+template <int N>
+Dual<N> operator*(Dual<N> x, const Dual<N>& y) {
+  return x *= y;
+}
+template <int N>
+Dual<N> operator*(Dual<N> x, double y) {
+  return x *= Dual<N>(y);
+}
+template <int N>
+Dual<N> operator*(double x, const Dual<N>& y) {
+  return Dual<N>(x) *= y;
+}
+
+template <int N>
+Dual<N> operator/(Dual<N> x, const Dual<N>& y) {
+  return x /= y;
+}
+template <int N>
+Dual<N> operator/(Dual<N> x, double y) {
+  return x /= Dual<N>(y);
+}
+template <int N>
+Dual<N> operator/(double x, const Dual<N>& y) {
+  return Dual<N>(x) /= y;
+}
+
+template <int N>
+bool operator<(const Dual<N>& x, const Dual<N>& y) {
+  return x.v < y.v;
+}
+template <int N>
+bool operator>(const Dual<N>& x, const Dual<N>& y) {
+  return x.v > y.v;
+}
+template <int N>
+bool operator<=(const Dual<N>& x, const Dual<N>& y) {
+  return x.v <= y.v;
+}
+template <int N>
+bool operator>=(const Dual<N>& x, const Dual<N>& y) {
+  return x.v >= y.v;
+}
+
+/// Value of a plain number or a dual
+inline double Value(double x) { return x; }
+template <int N>
+double Value(const Dual<N>& x) {
+  return x.v;
+}
+
+}  // namespace tricycle
+
+#endif  // CYCLUS_TRICYCLE_DUAL_H_
@@ -0,0 +1,495 @@
+// fuel_cycle_engine.cc
+
+#include "fuel_cycle_engine.h"
+
+#include <algorithm>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+
+#include "plant_kernels.h"
+
+namespace tricycle {
+
+namespace {
+
+// Same as cyclus::eps_rsrc(), below which FusionPowerPlant ignores a
+// quantity
+constexpr double kEps = 1e-6;
+
+// Tritium storage FusionPowerPlant's fuel tracker holds at most (kg)
+constexpr double kFuelLimit = 1000.0;
+
+const double kMWToGW = 1000;
+// kg of tritium burned per GW-year of fusion power, as in FusionPowerPlant
+const double kBurnRate = 55.8;
+
+/// Moves qty kg of a T/He-3 inventory out, keeping its composition
+void Move(double qty, double* tritium, double* helium3, double* to_tritium,
+          double* to_helium3) {
+  double total = *tritium + *helium3;
+  if (total <= 0 || qty <= 0) {
+    return;
+  }
+  double frac = std::min(qty / total, 1.0);
+  double t = *tritium * frac;
+  double h = *helium3 * frac;
+  *tritium -= t;
+  *helium3 -= h;
+  if (to_tritium != NULL) {
+    *to_tritium += t;
+    *to_helium3 += h;
+  }
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// csv reading
+
+std::string Trim(const std::string& s) {
+  size_t begin = s.find_first_not_of(" \t\r\n");
+  if (begin == std::string::npos) {
+    return "";
+  }
+  size_t end = s.find_last_not_of(" \t\r\n");
+  return s.substr(begin, end - begin + 1);
+}
+
+std::vector<std::string> SplitRow(const std::string& line) {
+  std::vector<std::string> fields;
+  std::stringstream ss(line);
+  std::string field;
+  while (std::getline(ss, field, ',')) {
+    fields.push_back(Trim(field));
+  }
+  return fields;
+}
+
+/// Rows of a csv file as maps from the header's column names to values
+std::vector<std::map<std::string, std::string> > ReadRows(std::istream& in) {
+  std::vector<std::map<std::string, std::string> > rows;
+  std::string line;
+  std::vector<std::string> header;
+  while (std::getline(in, line)) {
+    if (Trim(line).empty()) {
+      continue;
+    }
+    std::vector<std::string> fields = SplitRow(line);
+    if (header.empty()) {
+      header = fields;
+      continue;
+    }
+    if (fields.size() > header.size()) {
+      throw std::invalid_argument("csv row has more fields than the header: " +
+                                  line);
+    }
+    std::map<std::string, std::string> row;
+    for (size_t i = 0; i < fields.size(); ++i) {
+      row[header[i]] = fields[i];
+    }
+    rows.push_back(row);
+  }
+  return rows;
+}
+
+/// Sets value from column key of row, if present
+template <class T>
+void Get(const std::map<std::string, std::string>& row, const std::string& key,
+         T* value) {
+  std::map<std::string, std::string>::const_iterator it = row.find(key);
+  if (it == row.end() || it->second.empty()) {
+    return;
+  }
+  std::stringstream ss(it->second);
+  ss >> *value;
+  if (ss.fail() || !ss.eof()) {
+    throw std::invalid_argument("bad value '" + it->second + "' for " + key);
+  }
+}
+
+template <>
+void Get(const std::map<std::string, std::string>& row, const std::string& key,
+         std::string* value) {
+  std::map<std::string, std::string>::const_iterator it = row.find(key);
+  if (it != row.end()) {
+    *value = it->second;
+  }
+}
+
+}  // namespace
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+FuelCycleEngine::FuelCycleEngine(const std::vector<PlantSpec>& specs,
+                                 const std::vector<Deployment>& deployments,
+                                 const SupplySpec& supply, int duration,
+                                 double dt)
+    : specs_(specs),
+      deployments_(deployments),
+      supply_(supply),
+      duration_(duration),
+      dt_(dt),
+      time_(0),
+      market_(supply.initial_inventory),
+      stochastic_(false) {
+  std::map<std::string, int> index;
+  for (size_t i = 0; i < specs_.size(); ++i) {
+    const PlantSpec& spec = specs_[i];
+    if (spec.refuel_mode != "fill" && spec.refuel_mode != "schedule") {
+      throw std::invalid_argument("Refuel mode " + spec.refuel_mode + " of " +
+                                  spec.name +
+                                  " not recognized! Try 'schedule' or 'fill'.");
+    }
+    if (spec.buy_frequency < 1) {
+      throw std::invalid_argument("buy_frequency of " + spec.name +
+                                  " must be at least 1");
+    }
+    if (spec.availability <= 0 || spec.availability > 1 ||
+        spec.mean_outage <= 0) {
+      throw std::invalid_argument(
+          "availability of " + spec.name +
+          " must be in (0, 1] and its mean_outage positive");
+    }
+    index[spec.name] = i;
+  }
+
+  // Every plant gets its slot up front, in order of deployment
+  for (size_t d = 0; d < deployments_.size(); ++d) {
+    const Deployment& dep = deployments_[d];
+    std::map<std::string, int>::iterator it = index.find(dep.prototype);
+    if (it == index.end()) {
+      throw std::invalid_argument("no plant spec for prototype " +
+                                  dep.prototype);
+    }
+    const PlantSpec& spec = specs_[it->second];
+    for (int n = 0; n < dep.n_build; ++n) {
+      spec_.push_back(it->second);
+      enter_.push_back(dep.build_time);
+      exit_.push_back(dep.lifetime < 0 ? duration_
+                                       : dep.build_time + dep.lifetime);
+      fuel_usage_.push_back(spec.fusion_power / kMWToGW * kBurnRate /
+                            (kMonthSeconds * 12) * dt_);
+      reserve_.push_back(
+          StepReserve(spec.reserve_inventory, fuel_usage_.back()));
+    }
+  }
+
+  int n = spec_.size();
+  refill_start_.assign(n, -1);
+  std::vector<std::vector<double>*> arrays = {
+      &storage_,     &storage_he3_,     &excess_,  &excess_he3_,
+      &sequestered_, &sequestered_he3_, &request_, &offer_};
+  for (std::vector<double>* array : arrays) {
+    array->assign(n, 0.0);
+  }
+  down_.assign(n, false);
+  blanket_phase_.assign(n, 0);
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void FuelCycleEngine::Seed(uint64_t seed) {
+  stochastic_ = true;
+  rng_.seed(seed);
+  for (int i = 0; i < n_plants(); ++i) {
+    const PlantSpec& spec = specs_[spec_[i]];
+    int period = PeriodSteps(spec.blanket_turnover_frequency * kMonthSeconds,
+                             dt_);
+    blanket_phase_[i] = std::uniform_int_distribution<int>(0, period - 1)(rng_);
+  }
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+bool FuelCycleEngine::active(int i) const {
+  return time_ >= enter_[i] && time_ < exit_[i];
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void FuelCycleEngine::Run() {
+  while (time_ < duration_) {
+    Step();
+  }
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void FuelCycleEngine::Step() {
+  StepRecord rec;
+  rec.time = time_;
+
+  Decommission();
+  DecayInventories(&rec);
+  OperatePlants(&rec);
+  MoveExcess();
+  Exchange(&rec);
+  Record(&rec);
+
+  records_.push_back(rec);
+  ++time_;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void FuelCycleEngine::Decommission() {
+  // A decommissioned plant takes its inventories with it
+  for (int i = 0; i < n_plants(); ++i) {
+    if (time_ == exit_[i]) {
+      storage_[i] = storage_he3_[i] = 0;
+      excess_[i] = excess_he3_[i] = 0;
+      sequestered_[i] = sequestered_he3_[i] = 0;
+    }
+  }
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void FuelCycleEngine::DecayInventories(StepRecord* rec) {
+  // The market's helium-3 is taken out right away, as DecayStorage does
+  double surviving = TritiumSurvival(dt_);
+  DecayStep(surviving, &market_, &rec->helium3);
+
+  for (int i = 0; i < n_plants(); ++i) {
+    if (!active(i)) {
+      continue;
+    }
+    DecayStep(surviving, &storage_[i], &storage_he3_[i]);
+    DecayStep(surviving, &excess_[i], &excess_he3_[i]);
+    DecayStep(surviving, &sequestered_[i], &sequestered_he3_[i]);
+  }
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void FuelCycleEngine::OperatePlants(StepRecord* rec) {
+  for (int i = 0; i < n_plants(); ++i) {
+    if (!active(i)) {
+      continue;
+    }
+    const PlantSpec& spec = specs_[spec_[i]];
+
+    // Helium-3 extraction, before anything is checked
+    if (storage_he3_[i] > kEps) {
+      rec->helium3 += storage_he3_[i];
+      storage_he3_[i] = 0;
+    }
+    if (excess_he3_[i] > kEps) {
+      rec->helium3 += excess_he3_[i];
+      excess_he3_[i] = 0;
+    }
+
+    // Outages run their course whether or not the plant has fuel
+    bool loaded = refill_start_[i] >= 0;
+    if (loaded && stochastic_ && Outage(i)) {
+      ++rec->outages;
+      continue;
+    }
+
+    double storage = storage_[i] + storage_he3_[i];
+    bool started = sequestered_[i] + sequestered_he3_[i] >= kEps;
+    double gap = SequesteredGap(spec.sequestered_equilibrium, sequestered_[i]);
+    double required =
+        RequiredStorage(started, gap, reserve_[i],
+                        spec.tritium_startup_fraction, fuel_usage_[i]);
+    if (storage < required) {
+      continue;
+    }
+
+    ++rec->operating;
+    if (!loaded) {
+      refill_start_[i] = time_;
+    }
+
+    if (gap > kEps) {
+      Move(gap, &storage_[i], &storage_he3_[i], &sequestered_[i],
+           &sequestered_he3_[i]);
+    }
+
+    // The blanket is filled on the first start, and turned over after that
+    if (loaded) {
+      int cycles =
+          BlanketCycles(time_ + blanket_phase_[i],
+                        spec.blanket_turnover_frequency * kMonthSeconds, dt_);
+      rec->blanket_waste += BlanketTurnover(
+          cycles, spec.blanket_size * spec.blanket_turnover_fraction,
+          spec.blanket_size);
+    }
+
+    Move(fuel_usage_[i], &storage_[i], &storage_he3_[i], NULL, NULL);
+    double bred = fuel_usage_[i] * spec.TBR;
+    BreedingYield yield = Breeding(bred, spec.Li7_contribution);
+    storage_[i] += bred;
+
+    rec->burned += fuel_usage_[i];
+    rec->bred += bred;
+    rec->lithium += yield.li6 + yield.li7;
+  }
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+bool FuelCycleEngine::Outage(int i) {
+  const PlantSpec& spec = specs_[spec_[i]];
+  // Transition probabilities per time step that keep the plant up for
+  // availability of the time on average, with outages of mean_outage months
+  double recover = std::min(dt_ / kMonthSeconds / spec.mean_outage, 1.0);
+  double fail = std::min(
+      recover * (1 - spec.availability) / spec.availability, 1.0);
+  double draw = std::uniform_real_distribution<double>(0, 1)(rng_);
+  down_[i] = down_[i] ? draw >= recover : draw < fail;
+  return down_[i];
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void FuelCycleEngine::MoveExcess() {
+  for (int i = 0; i < n_plants(); ++i) {
+    if (!active(i)) {
+      continue;
+    }
+    const PlantSpec& spec = specs_[spec_[i]];
+    double gap = SequesteredGap(spec.sequestered_equilibrium, sequestered_[i]);
+    double excess =
+        ExcessStorage(storage_[i] + storage_he3_[i], reserve_[i], gap);
+    if (excess > kEps) {
+      Move(excess, &storage_[i], &storage_he3_[i], &excess_[i],
+           &excess_he3_[i]);
+    }
+  }
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+double FuelCycleEngine::FuelDemand(int i) {
+  const PlantSpec& spec = specs_[spec_[i]];
+  double inventory = storage_[i] + storage_he3_[i];
+  double space = std::max(kFuelLimit - inventory, 0.0);
+
+  // Startup policy: fill to the full startup inventory
+  if (refill_start_[i] < 0) {
+    double startup = reserve_[i] + spec.sequestered_equilibrium;
+    return inventory <= startup ? std::min(startup - inventory, space) : 0;
+  }
+
+  // Refill policy
+  if (spec.refuel_mode == "schedule") {
+    double period = spec.buy_frequency * kMonthSeconds;
+    int steps = PeriodSteps(period, dt_);
+    bool buying = (time_ - refill_start_[i]) % steps == 0;
+    return buying ? std::min(spec.buy_quantity * steps * dt_ / period, space)
+                  : 0;
+  }
+  return inventory <= reserve_[i]
+             ? std::min(reserve_[i] - inventory, space)
+             : 0;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void FuelCycleEngine::Exchange(StepRecord* rec) {
+  // Offers and room are what the market holds before anything moves
+  double available = std::min(market_, supply_.throughput);
+  double space = std::max(supply_.capacity - market_, 0.0);
+
+  double demand = 0;
+  bool supplying = supply_.supply_end < 0 || time_ < supply_.supply_end;
+  double offered = supplying ? supply_.external_supply : 0;
+  for (int i = 0; i < n_plants(); ++i) {
+    request_[i] = active(i) ? FuelDemand(i) : 0;
+    offer_[i] = active(i) && supply_.buy_excess ? excess_[i] + excess_he3_[i]
+                                                : 0;
+    demand += request_[i];
+    offered += offer_[i];
+  }
+
+  // Shortfalls are shared in proportion to the requests and offers
+  double deliver_frac = demand > available ? available / demand : 1.0;
+  double take_frac = offered > space ? space / offered : 1.0;
+  for (int i = 0; i < n_plants(); ++i) {
+    if (request_[i] > kEps) {
+      storage_[i] += request_[i] * deliver_frac;
+    }
+    if (offer_[i] > kEps) {
+      Move(offer_[i] * take_frac, &excess_[i], &excess_he3_[i], NULL, NULL);
+    }
+  }
+
+  double delivered = demand * deliver_frac;
+  double sold = std::max(std::min(supply_.sales, available - delivered), 0.0);
+  market_ += offered * take_frac - delivered - sold;
+  rec->delivered = delivered;
+  rec->unmet = demand - delivered;
+  rec->sold = sold;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void FuelCycleEngine::Record(StepRecord* rec) {
+  for (int i = 0; i < n_plants(); ++i) {
+    if (!active(i)) {
+      continue;
+    }
+    ++rec->plants;
+    rec->storage += storage(i);
+    rec->excess += excess(i);
+    rec->sequestered += sequestered(i);
+  }
+  rec->market = market_;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+std::vector<PlantSpec> ReadPlantSpecs(std::istream& in) {
+  std::vector<PlantSpec> specs;
+  std::vector<std::map<std::string, std::string> > rows = ReadRows(in);
+  for (size_t i = 0; i < rows.size(); ++i) {
+    const std::map<std::string, std::string>& row = rows[i];
+    PlantSpec spec;
+    Get(row, "name", &spec.name);
+    if (spec.name.empty()) {
+      throw std::invalid_argument("plant spec without a name");
+    }
+    Get(row, "fusion_power", &spec.fusion_power);
+    Get(row, "TBR", &spec.TBR);
+    Get(row, "reserve_inventory", &spec.reserve_inventory);
+    Get(row, "sequestered_equilibrium", &spec.sequestered_equilibrium);
+    Get(row, "tritium_startup_fraction", &spec.tritium_startup_fraction);
+    Get(row, "Li7_contribution", &spec.Li7_contribution);
+    Get(row, "refuel_mode", &spec.refuel_mode);
+    Get(row, "buy_quantity", &spec.buy_quantity);
+    Get(row, "buy_frequency", &spec.buy_frequency);
+    Get(row, "blanket_size", &spec.blanket_size);
+    Get(row, "blanket_turnover_fraction", &spec.blanket_turnover_fraction);
+    Get(row, "blanket_turnover_frequency", &spec.blanket_turnover_frequency);
+    Get(row, "availability", &spec.availability);
+    Get(row, "mean_outage", &spec.mean_outage);
+    specs.push_back(spec);
+  }
+  return specs;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+std::vector<Deployment> ReadDeployments(std::istream& in) {
+  std::vector<Deployment> deployments;
+  std::vector<std::map<std::string, std::string> > rows = ReadRows(in);
+  for (size_t i = 0; i < rows.size(); ++i) {
+    const std::map<std::string, std::string>& row = rows[i];
+    Deployment dep;
+    Get(row, "region_name", &dep.region_name);
+    Get(row, "institution", &dep.institution);
+    Get(row, "prototypes", &dep.prototype);
+    Get(row, "build_times", &dep.build_time);
+    Get(row, "lifetimes", &dep.lifetime);
+    Get(row, "n_build", &dep.n_build);
+    if (dep.prototype.empty()) {
+      throw std::invalid_argument("deployment without a prototype");
+    }
+    deployments.push_back(dep);
+  }
+  return deployments;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void WriteRecords(const std::vector<StepRecord>& records, std::ostream& out) {
+  out << "Time,Plants,Operating,Outages,TritiumStorage,TritiumExcess,"
+         "TritiumSequestered,Market,Delivered,Unmet,Sold,Bred,Burned,Helium3,"
+         "BlanketWaste,Lithium\n";
+  for (size_t i = 0; i < records.size(); ++i) {
+    const StepRecord& r = records[i];
+    out << r.time << "," << r.plants << "," << r.operating << ","
+        << r.outages << ","
+        << r.storage << "," << r.excess << "," << r.sequestered << ","
+        << r.market << "," << r.delivered << "," << r.unmet << "," << r.sold
+        << "," << r.bred
+        << "," << r.burned << "," << r.helium3 << "," << r.blanket_waste << ","
+        << r.lithium << "\n";
+  }
+}
+
+}  // namespace tricycle
@@ -0,0 +1,208 @@
+#ifndef CYCLUS_TRICYCLE_FUEL_CYCLE_ENGINE_H_
+#define CYCLUS_TRICYCLE_FUEL_CYCLE_ENGINE_H_
+
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace tricycle {
+
+/// Seconds in the default (monthly) cyclus time step
+constexpr double kMonthSeconds = 2629846;
+
+/// Parameters of one fusion power plant design, with the names, units and
+/// defaults of the FusionPowerPlant parameters. One row of FPPInput.csv.
+struct PlantSpec {
+  std::string name;
+  double fusion_power = 0;
+  double TBR = 0;
+  double reserve_inventory = 0;
+  double sequestered_equilibrium = 0;
+  double tritium_startup_fraction = 0.9;
+  double Li7_contribution = 0.03;
+  std::string refuel_mode = "fill";
+  double buy_quantity = 0.1;
+  int buy_frequency = 1;
+  double blanket_size = 1000;
+  double blanket_turnover_fraction = 0.05;
+  int blanket_turnover_frequency = 1;
+  /// Long-run fraction of time steps a started plant is not in an outage.
+  /// Only used once the engine is seeded.
+  double availability = 1;
+  /// Mean length of an outage (months)
+  double mean_outage = 1;
+};
+
+/// Plants of one prototype built at one time. One row of DeployIn.csv.
+struct Deployment {
+  std::string region_name;
+  std::string institution;
+  std::string prototype;
+  int build_time = 0;
+  int lifetime = -1;
+  int n_build = 1;
+};
+
+/// The tritium market the plants buy from and sell to, standing in for a
+/// DecayStorage facility and whatever external sources feed it
+struct SupplySpec {
+  /// Tritium held at the start of the simulation (kg)
+  double initial_inventory = 0;
+  /// Tritium delivered from outside the fleet every time step (kg)
+  double external_supply = 0;
+  /// Time step the external supply stops at; never when negative
+  int supply_end = -1;
+  /// Tritium taken off the market every time step after the plants are
+  /// served, as by a Sink (kg)
+  double sales = 0;
+  /// Most tritium shipped to plants per time step (kg)
+  double throughput = 1e299;
+  /// Most tritium held (kg)
+  double capacity = 1e299;
+  /// Whether plants sell their excess tritium back to the market. Without
+  /// it the excess stays with the plant, as with no buyer in cyclus.
+  bool buy_excess = true;
+};
+
+/// Fleet totals at the end of a time step (kg, or kg per time step for
+/// flows)
+struct StepRecord {
+  int time = 0;
+  int plants = 0;
+  int operating = 0;
+  /// Started plants held down by an outage
+  int outages = 0;
+  double storage = 0;
+  double excess = 0;
+  double sequestered = 0;
+  double market = 0;
+  double delivered = 0;
+  double unmet = 0;
+  double sold = 0;
+  double bred = 0;
+  double burned = 0;
+  double helium3 = 0;
+  double blanket_waste = 0;
+  double lithium = 0;
+};
+
+/// Tritium held by the plants and the market together (kg)
+inline double TotalTritium(const StepRecord& r) {
+  return r.storage + r.excess + r.sequestered + r.market;
+}
+
+/// @class FuelCycleEngine
+/// The tritium balance of a deployed fleet of fusion power plants, without
+/// cyclus. Every plant follows FusionPowerPlant::Tick with the kernels in
+/// plant_kernels.h: decay, helium-3 extraction, the startup and operation
+/// check, sequestration, burn, breeding and the move of surplus tritium to
+/// excess. The exchange is replaced by a single market: each plant asks for
+/// what its startup or refill policy would request, and shortfalls are
+/// shared in proportion to the requests, as FusionFleet shares deliveries.
+/// Tritium reaching the market during a time step can only be shipped on
+/// the next one, like a DecayStorage's offers.
+///
+/// Blanket feed is taken to be always available, so blanket turnover never
+/// holds a plant back; the blanket only shows up as waste and lithium burn.
+///
+/// A seeded engine also draws plant outages and blanket turnover timing from
+/// its own random stream; see Seed.
+class FuelCycleEngine {
+ public:
+  /// @throws std::invalid_argument if a deployment names a plant that is
+  /// not in specs, a refuel mode other than 'fill' or 'schedule' is used, or
+  /// an availability is outside (0, 1]
+  FuelCycleEngine(const std::vector<PlantSpec>& specs,
+                  const std::vector<Deployment>& deployments,
+                  const SupplySpec& supply, int duration,
+                  double dt = kMonthSeconds);
+
+  /// Turns on stochastic operation, drawn from a stream seeded with seed.
+  /// Started plants go down and come back as a two-state Markov chain with
+  /// their availability and mean outage length, and neither burn nor breed
+  /// while down. Each plant's blanket turnovers are shifted by a random
+  /// part of its turnover period. Call before the first Step.
+  void Seed(uint64_t seed);
+
+  /// Runs the remaining time steps
+  void Run();
+
+  /// Runs one time step and records it
+  void Step();
+
+  int time() const { return time_; }
+  const std::vector<StepRecord>& records() const { return records_; }
+
+  /// Per-plant state, in order of deployment
+  int n_plants() const { return spec_.size(); }
+  bool active(int i) const;
+  double storage(int i) const { return storage_[i] + storage_he3_[i]; }
+  double excess(int i) const { return excess_[i] + excess_he3_[i]; }
+  double sequestered(int i) const {
+    return sequestered_[i] + sequestered_he3_[i];
+  }
+  double market() const { return market_; }
+
+ private:
+  /// Empties the plants reaching the end of their lifetime
+  void Decommission();
+  void DecayInventories(StepRecord* rec);
+  void OperatePlants(StepRecord* rec);
+  void MoveExcess();
+  void Exchange(StepRecord* rec);
+  double FuelDemand(int i);
+  /// Whether started plant i is down this time step, advancing its outage
+  /// state
+  bool Outage(int i);
+  void Record(StepRecord* rec);
+
+  std::vector<PlantSpec> specs_;
+  std::vector<Deployment> deployments_;
+  SupplySpec supply_;
+  int duration_;
+  double dt_;
+  int time_;
+
+  // Per-plant state, structure of arrays
+  std::vector<int> spec_;
+  std::vector<int> enter_;
+  std::vector<int> exit_;
+  std::vector<int> refill_start_;
+  std::vector<double> fuel_usage_;
+  std::vector<double> reserve_;
+  std::vector<double> storage_;
+  std::vector<double> storage_he3_;
+  std::vector<double> excess_;
+  std::vector<double> excess_he3_;
+  std::vector<double> sequestered_;
+  std::vector<double> sequestered_he3_;
+  std::vector<double> request_;
+  std::vector<double> offer_;
+  std::vector<bool> down_;
+  std::vector<int> blanket_phase_;
+
+  double market_;
+  bool stochastic_;
+  std::mt19937_64 rng_;
+  std::vector<StepRecord> records_;
+};
+
+/// Reads plant designs in the FPPInput.csv format. Columns the engine does
+/// not use (commodities, recipes) are ignored, missing ones get the
+/// FusionPowerPlant defaults.
+/// @throws std::invalid_argument on a malformed file
+std::vector<PlantSpec> ReadPlantSpecs(std::istream& in);
+
+/// Reads a deployment schedule in the DeployIn.csv format
+/// @throws std::invalid_argument on a malformed file
+std::vector<Deployment> ReadDeployments(std::istream& in);
+
+/// Writes records as csv, one row per time step
+void WriteRecords(const std::vector<StepRecord>& records, std::ostream& out);
+
+}  // namespace tricycle
+
+#endif  // CYCLUS_TRICYCLE_FUEL_CYCLE_ENGINE_H_
@@ -0,0 +1,182 @@
+#include <gtest/gtest.h>
+
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "agent_tests.h"
+#include "context.h"
+#include "facility_tests.h"
+#include "fuel_cycle_engine.h"
+#include "pyhooks.h"
+
+using cyclus::Cond;
+using cyclus::QueryResult;
+
+namespace tricycle {
+namespace {
+
+cyclus::Composition::Ptr pure_tritium() {
+  cyclus::CompMap m;
+  m[10030000] = 1.0;
+  return cyclus::Composition::CreateFromAtom(m);
+}
+
+cyclus::Composition::Ptr lithium_feed() {
+  cyclus::CompMap m;
+  m[30060000] = 0.3;
+  m[30070000] = 0.7;
+  return cyclus::Composition::CreateFromAtom(m);
+}
+
+std::string fpp_csv =
+    "name,fusion_power,TBR,reserve_inventory,sequestered_equilibrium,"
+    "fuel_incommod,Li7_contribution,refuel_mode,buy_quantity,buy_frequency,"
+    "he3_outcommod,blanket_inrecipe,blanket_incommod,blanket_outcommod,"
+    "blanket_size,blanket_turnover_fraction,blanket_turnover_frequency\n"
+    "PlantOne,300,1.08,6.0,2.121,Tritium,0.03,fill,0.1,1,Helium_3,"
+    "enriched_lithium,Enriched_Lithium,Depleted_Lithium,1000,0.03,1\n";
+
+std::vector<PlantSpec> Specs() {
+  std::stringstream ss(fpp_csv);
+  return ReadPlantSpecs(ss);
+}
+
+std::vector<Deployment> Deploy(const std::string& rows) {
+  std::stringstream ss(
+      "region_name,institution,prototypes,build_times,lifetimes,n_build\n" +
+      rows);
+  return ReadDeployments(ss);
+}
+
+SupplySpec Unlimited() {
+  SupplySpec supply;
+  supply.initial_inventory = 1e6;
+  supply.buy_excess = false;
+  return supply;
+}
+
+}  // namespace
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+TEST(FuelCycleEngineTest, ReadInputs) {
+  std::vector<PlantSpec> specs = Specs();
+  ASSERT_EQ(1, specs.size());
+  EXPECT_EQ("PlantOne", specs[0].name);
+  EXPECT_DOUBLE_EQ(300, specs[0].fusion_power);
+  EXPECT_DOUBLE_EQ(2.121, specs[0].sequestered_equilibrium);
+  EXPECT_EQ("fill", specs[0].refuel_mode);
+  // Not a column, so the FusionPowerPlant default
+  EXPECT_DOUBLE_EQ(0.9, specs[0].tritium_startup_fraction);
+
+  std::vector<Deployment> deps = Deploy(
+      "OneRegion,FusionPower,PlantOne,2,350,2\n"
+      "OneRegion,FusionPower,PlantOne,5,350,4\n");
+  ASSERT_EQ(2, deps.size());
+  EXPECT_EQ(5, deps[1].build_time);
+  EXPECT_EQ(4, deps[1].n_build);
+
+  FuelCycleEngine engine(specs, deps, SupplySpec(), 10);
+  EXPECT_EQ(6, engine.n_plants());
+
+  std::stringstream bad("name,TBR\nPlantOne,high\n");
+  EXPECT_THROW(ReadPlantSpecs(bad), std::invalid_argument);
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+TEST(FuelCycleEngineTest, UnknownPrototype) {
+  EXPECT_THROW(FuelCycleEngine(Specs(),
+                               Deploy("OneRegion,FusionPower,PlantTwo,0,-1,1\n"),
+                               SupplySpec(), 10),
+               std::invalid_argument);
+
+  std::vector<PlantSpec> specs = Specs();
+  specs[0].refuel_mode = "forecast";
+  EXPECT_THROW(FuelCycleEngine(specs,
+                               Deploy("OneRegion,FusionPower,PlantOne,0,-1,1\n"),
+                               SupplySpec(), 10),
+               std::invalid_argument);
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+TEST(FuelCycleEngineTest, StartupAfterDelivery) {
+  // A plant built at time 2 gets its startup inventory then and starts on
+  // the following time step
+  FuelCycleEngine engine(Specs(),
+                         Deploy("OneRegion,FusionPower,PlantOne,2,-1,1\n"),
+                         Unlimited(), 5);
+  engine.Run();
+
+  const std::vector<StepRecord>& recs = engine.records();
+  EXPECT_EQ(0, recs[1].plants);
+  EXPECT_EQ(1, recs[2].plants);
+  EXPECT_EQ(0, recs[2].operating);
+  EXPECT_NEAR(8.121, recs[2].delivered, 1e-9);
+  EXPECT_EQ(1, recs[3].operating);
+  EXPECT_LT(0, recs[3].sequestered);
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+TEST(FuelCycleEngineTest, InsufficientSupply) {
+  // Half a startup inventory, shared by two plants, starts neither of them
+  SupplySpec supply;
+  supply.initial_inventory = 4.0;
+  FuelCycleEngine engine(Specs(),
+                         Deploy("OneRegion,FusionPower,PlantOne,0,-1,2\n"),
+                         supply, 6);
+  engine.Run();
+
+  for (const StepRecord& rec : engine.records()) {
+    EXPECT_EQ(0, rec.operating);
+    EXPECT_EQ(0, rec.burned);
+  }
+  EXPECT_NEAR(engine.storage(0), engine.storage(1), 1e-12);
+  EXPECT_LT(0, engine.records().back().unmet);
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+TEST(FuelCycleEngineTest, MatchesFusionPowerPlant) {
+  // A lone plant that is never short of fuel follows the archetype
+  int simdur = 10;
+  std::string config =
+      " <fusion_power>300</fusion_power>"
+      " <TBR>1.08</TBR>"
+      " <reserve_inventory>6.0</reserve_inventory>"
+      " <sequestered_equilibrium>2.121</sequestered_equilibrium>"
+      " <fuel_incommod>Tritium</fuel_incommod>"
+      " <blanket_incommod>Enriched_Lithium</blanket_incommod>"
+      " <blanket_outcommod>Depleted_Lithium</blanket_outcommod>"
+      " <blanket_inrecipe>enriched_lithium</blanket_inrecipe>"
+      " <blanket_size>1000</blanket_size>"
+      " <blanket_turnover_fraction>0.03</blanket_turnover_fraction>"
+      " <he3_outcommod>Helium_3</he3_outcommod>";
+
+  cyclus::MockSim sim(cyclus::AgentSpec(":tricycle:FusionPowerPlant"), config,
+                      simdur);
+  sim.AddRecipe("tritium", pure_tritium());
+  sim.AddRecipe("enriched_lithium", lithium_feed());
+  sim.AddSource("Enriched_Lithium").recipe("enriched_lithium").Finalize();
+  sim.AddSource("Tritium").recipe("tritium").Finalize();
+  sim.Run();
+
+  FuelCycleEngine engine(Specs(),
+                         Deploy("OneRegion,FusionPower,PlantOne,0,-1,1\n"),
+                         Unlimited(), simdur);
+  engine.Run();
+
+  for (const StepRecord& rec : engine.records()) {
+    std::vector<Cond> conds;
+    conds.push_back(Cond("Time", "==", rec.time));
+    QueryResult qr = sim.db().Query("FPPInventories", &conds);
+    EXPECT_NEAR(qr.GetVal<double>("TritiumStorage"), rec.storage, 1e-6)
+        << "at time " << rec.time;
+    EXPECT_NEAR(qr.GetVal<double>("TritiumSequestered"), rec.sequestered,
+                1e-6)
+        << "at time " << rec.time;
+    EXPECT_NEAR(qr.GetVal<double>("TritiumExcess"), rec.excess, 1e-6)
+        << "at time " << rec.time;
+  }
+}
+
+}  // namespace tricycle
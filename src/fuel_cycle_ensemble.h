@@ -0,0 +1,56 @@
+#ifndef CYCLUS_TRICYCLE_FUEL_CYCLE_ENSEMBLE_H_
+#define CYCLUS_TRICYCLE_FUEL_CYCLE_ENSEMBLE_H_
+
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+#include "fuel_cycle_engine.h"
+
+namespace tricycle {
+
+/// Size, seed and parallelism of an ensemble
+struct EnsembleSpec {
+  int realizations = 1000;
+  uint64_t seed = 0;
+  /// Worker threads; all hardware threads when 0
+  int threads = 0;
+  /// Percentiles of the bands, between 0 and 100
+  std::vector<double> percentiles = {5, 25, 50, 75, 95};
+};
+
+/// Percentile bands of the global tritium inventory (kg): every plant's
+/// storage, excess and sequestered tritium plus the market, at the end of
+/// each time step
+struct EnsembleBands {
+  std::vector<double> percentiles;
+  /// bands[t][p] is percentile p of the inventory at time step t
+  std::vector<std::vector<double> > bands;
+  std::vector<double> mean;
+  /// Fraction of the realizations with unmet demand at each time step
+  std::vector<double> shortfall;
+};
+
+/// Next value of a SplitMix64 stream with the given state
+uint64_t SplitMix64(uint64_t* state);
+
+/// Seed of one realization of an ensemble. It depends only on the ensemble
+/// seed and the realization's index, so results do not depend on the number
+/// of threads or on which thread runs which realization.
+uint64_t RealizationSeed(uint64_t seed, int realization);
+
+/// Runs spec.realizations seeded copies of a FuelCycleEngine on
+/// spec.threads threads and reduces them to percentile bands
+/// @throws std::invalid_argument as FuelCycleEngine does, or for a
+/// percentile outside [0, 100]
+EnsembleBands RunEnsemble(const std::vector<PlantSpec>& specs,
+                          const std::vector<Deployment>& deployments,
+                          const SupplySpec& supply, int duration, double dt,
+                          const EnsembleSpec& spec);
+
+/// Writes bands as csv, one row per time step
+void WriteBands(const EnsembleBands& bands, std::ostream& out);
+
+}  // namespace tricycle
+
+#endif  // CYCLUS_TRICYCLE_FUEL_CYCLE_ENSEMBLE_H_
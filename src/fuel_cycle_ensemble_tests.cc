@@ -0,0 +1,115 @@
+#include <gtest/gtest.h>
+
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "fuel_cycle_ensemble.h"
+
+namespace tricycle {
+namespace {
+
+std::vector<PlantSpec> Specs(double availability) {
+  std::stringstream ss(
+      "name,fusion_power,TBR,reserve_inventory,sequestered_equilibrium,"
+      "blanket_turnover_frequency,availability,mean_outage\n"
+      "PlantOne,300,1.08,6.0,2.121,12," +
+      std::to_string(availability) + ",2\n");
+  return ReadPlantSpecs(ss);
+}
+
+std::vector<Deployment> Deploy() {
+  std::stringstream ss(
+      "region_name,institution,prototypes,build_times,lifetimes,n_build\n"
+      "OneRegion,FusionPower,PlantOne,0,-1,3\n");
+  return ReadDeployments(ss);
+}
+
+SupplySpec Supply() {
+  SupplySpec supply;
+  supply.initial_inventory = 40;
+  return supply;
+}
+
+}  // namespace
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+TEST(FuelCycleEnsembleTest, SeedsIndependentOfThreads) {
+  EnsembleSpec spec;
+  spec.realizations = 64;
+  spec.seed = 11;
+
+  spec.threads = 1;
+  EnsembleBands serial =
+      RunEnsemble(Specs(0.7), Deploy(), Supply(), 36, kMonthSeconds, spec);
+  spec.threads = 4;
+  EnsembleBands parallel =
+      RunEnsemble(Specs(0.7), Deploy(), Supply(), 36, kMonthSeconds, spec);
+
+  EXPECT_EQ(serial.bands, parallel.bands);
+  EXPECT_EQ(serial.mean, parallel.mean);
+
+  EXPECT_EQ(RealizationSeed(11, 3), RealizationSeed(11, 3));
+  EXPECT_NE(RealizationSeed(11, 3), RealizationSeed(11, 4));
+  EXPECT_NE(RealizationSeed(11, 3), RealizationSeed(12, 3));
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+TEST(FuelCycleEnsembleTest, FullAvailabilityIsDeterministic) {
+  // Without outages every realization follows the unseeded engine
+  int duration = 24;
+  FuelCycleEngine engine(Specs(1.0), Deploy(), Supply(), duration);
+  engine.Run();
+
+  EnsembleSpec spec;
+  spec.realizations = 8;
+  EnsembleBands bands =
+      RunEnsemble(Specs(1.0), Deploy(), Supply(), duration, kMonthSeconds,
+                  spec);
+
+  for (int t = 0; t < duration; ++t) {
+    const StepRecord& rec = engine.records()[t];
+    double total = TotalTritium(rec);
+    EXPECT_DOUBLE_EQ(total, bands.bands[t].front()) << "at time " << t;
+    EXPECT_DOUBLE_EQ(total, bands.bands[t].back()) << "at time " << t;
+  }
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+TEST(FuelCycleEnsembleTest, OutagesWidenBands) {
+  int duration = 60;
+  EnsembleSpec spec;
+  spec.realizations = 200;
+  spec.percentiles = {5, 50, 95};
+
+  EnsembleBands full =
+      RunEnsemble(Specs(1.0), Deploy(), Supply(), duration, kMonthSeconds,
+                  spec);
+  EnsembleBands partial =
+      RunEnsemble(Specs(0.6), Deploy(), Supply(), duration, kMonthSeconds,
+                  spec);
+
+  const std::vector<double>& last = partial.bands.back();
+  EXPECT_LE(last[0], last[1]);
+  EXPECT_LE(last[1], last[2]);
+  EXPECT_LT(last[0], last[2]);
+
+  // With a TBR above one, time lost to outages is tritium not bred
+  EXPECT_LT(partial.mean.back(), full.mean.back());
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+TEST(FuelCycleEnsembleTest, InvalidInput) {
+  EnsembleSpec spec;
+  spec.realizations = 1;
+  spec.percentiles = {50, 101};
+  EXPECT_THROW(RunEnsemble(Specs(1.0), Deploy(), Supply(), 12, kMonthSeconds,
+                           spec),
+               std::invalid_argument);
+
+  EXPECT_THROW(FuelCycleEngine(Specs(0.0), Deploy(), Supply(), 12),
+               std::invalid_argument);
+}
+
+}  // namespace tricycle
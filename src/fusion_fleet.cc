@@ -0,0 +1,648 @@
+// fusion_fleet.cc
+
+#include "fusion_fleet.h"
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+#include <sstream>
+
+using cyclus::BidPortfolio;
+using cyclus::CapacityConstraint;
+using cyclus::CompMap;
+using cyclus::Composition;
+using cyclus::Material;
+using cyclus::Request;
+using cyclus::RequestPortfolio;
+using cyclus::Trade;
+
+namespace tricycle {
+
+const double FusionFleet::burn_rate = 55.8;
+
+namespace {
+
+double Sum(const std::vector<double>& values) {
+  return std::accumulate(values.begin(), values.end(), 0.0);
+}
+
+/// Scales every entry of values by factor
+void Scale(std::vector<double>* values, double factor) {
+  for (double& value : *values) {
+    value *= factor;
+  }
+}
+
+/// Normalized mass fractions of comp
+CompMap MassFractions(Composition::Ptr comp) {
+  CompMap fractions = comp->mass();
+  double total = 0;
+  for (CompMap::const_iterator it = fractions.begin(); it != fractions.end();
+       ++it) {
+    total += it->second;
+  }
+  for (CompMap::iterator it = fractions.begin(); it != fractions.end(); ++it) {
+    it->second /= total;
+  }
+  return fractions;
+}
+
+/// Loads the cores of n plants: tops up their sequestered inventory, takes
+/// one step's worth of fuel and breeds. op is 1 for operating plants and 0
+/// for the rest, whose flows it scales to zero. Storage is clean in
+/// operating plants, so only T and He-3 move. The arrays must not overlap,
+/// which together with the absence of branches lets the loop vectorize.
+void LoadCores(int n, const double* __restrict op,
+               double sequestered_equilibrium, double fuel_usage_mass,
+               double bred, BreedingYield yield, double eps,
+               double* __restrict storage_tritium,
+               double* __restrict storage_helium3,
+               const double* __restrict storage_other,
+               double* __restrict sequestered_tritium,
+               double* __restrict sequestered_helium3,
+               double* __restrict blanket_li6, double* __restrict blanket_li7,
+               double* __restrict blanket_he4) {
+  // Denominators are kept positive instead of testing them. An empty
+  // storage has nothing to move either way, and storage left at or below
+  // zero was all sequestered, so it has no tritium left to burn.
+  const double tiny = std::numeric_limits<double>::min();
+  for (int i = 0; i < n; ++i) {
+    double storage =
+        storage_tritium[i] + storage_helium3[i] + storage_other[i];
+    double gap = SequesteredGap(sequestered_equilibrium, sequestered_tritium[i]);
+    double topped_up = gap > eps ? op[i] : 0.0;
+    double frac = topped_up * std::min(gap / std::max(storage, tiny), 1.0);
+    double tritium = storage_tritium[i] * frac;
+    double helium3 = storage_helium3[i] * frac;
+    sequestered_tritium[i] += tritium;
+    sequestered_helium3[i] += helium3;
+    storage_tritium[i] -= tritium;
+    storage_helium3[i] -= helium3;
+    storage -= topped_up * gap;
+
+    double burn_frac =
+        op[i] * std::min(fuel_usage_mass / std::max(storage, tiny), 1.0);
+    storage_tritium[i] -= storage_tritium[i] * burn_frac;
+    storage_helium3[i] -= storage_helium3[i] * burn_frac;
+
+    blanket_li6[i] = std::max(blanket_li6[i] - op[i] * yield.li6, 0.0);
+    blanket_li7[i] = std::max(blanket_li7[i] - op[i] * yield.li7, 0.0);
+    blanket_he4[i] += op[i] * yield.he4;
+    storage_tritium[i] += op[i] * bred;
+  }
+}
+
+}  // namespace
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+FusionFleet::FusionFleet(cyclus::Context* ctx)
+    : cyclus::Facility(ctx),
+      n_plants(0),
+      feed_li6_frac(0),
+      feed_li7_frac(0),
+      feed_he4_frac(0),
+      blanket_turnover(0),
+      fuel_usage_mass(0),
+      step_reserve(0),
+      buy_steps(1),
+      step_buy_quantity(0),
+      decay_time(0) {}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+std::string FusionFleet::str() {
+  std::stringstream ss;
+  ss << Facility::str() << " fleet of " << n_plants << " plants";
+  return ss.str();
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void FusionFleet::EnterNotify() {
+  cyclus::Facility::EnterNotify();
+
+  if (refuel_mode != "schedule" && refuel_mode != "fill") {
+    throw cyclus::KeyError("Refuel mode " + refuel_mode +
+                           " not recognized! Try 'schedule' or 'fill'.");
+  }
+  if (refuel_mode == "schedule" && buy_frequency < 1) {
+    throw cyclus::ValueError("buy_frequency must be at least 1");
+  }
+
+  fuel_usage_mass = (burn_rate * (fusion_power / 1000) /
+                     (kDefaultTimeStepDur * 12) * context()->dt());
+  blanket_turnover = blanket_size * blanket_turnover_fraction;
+  step_reserve = StepReserve(reserve_inventory, fuel_usage_mass);
+  if (refuel_mode == "schedule") {
+    // As in FusionPowerPlant, a purchase every buy_frequency months rounded
+    // to whole time steps, each buying for all the periods it covers
+    double period = buy_frequency * kDefaultTimeStepDur;
+    buy_steps = PeriodSteps(period, context()->dt());
+    step_buy_quantity =
+        ScheduledQuantity(buy_quantity, period, buy_steps, context()->dt());
+  }
+
+  // A restarted fleet already holds its per-plant state
+  size_t n = n_plants;
+  std::vector<std::vector<double>*> arrays = {
+      &storage_tritium, &storage_helium3,     &storage_other,
+      &excess_tritium,  &excess_helium3,      &excess_other,
+      &sequestered_tritium, &sequestered_helium3, &helium_excess,
+      &blanket_feed,    &blanket_li6,         &blanket_li7,
+      &blanket_he4,     &blanket_rest,        &blanket_waste};
+  for (std::vector<double>* array : arrays) {
+    if (array->size() != n) {
+      array->assign(n, 0.0);
+    }
+  }
+  if (refill_start.size() != n) {
+    refill_start.assign(n, -1);
+  }
+  online.assign(n, 0);
+  operate.assign(n, 0.0);
+  fuel_request.assign(n, 0.0);
+  blanket_request.assign(n, 0.0);
+  UpdateOnline();
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void FusionFleet::UpdateOnline() {
+  int elapsed = context()->time() - enter_time();
+  for (size_t i = 0; i < online.size(); ++i) {
+    int delay = i < plant_start_times.size() ? plant_start_times[i] : 0;
+    online[i] = elapsed >= delay;
+  }
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void FusionFleet::Tick() {
+  UpdateOnline();
+  DecayInventories();
+  ExtractHelium();
+  OperatePlants();
+  MoveExcess();
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void FusionFleet::Tock() {
+  RecordInventories();
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void FusionFleet::DecayInventories() {
+  int dt = context()->time() - decay_time;
+  decay_time = context()->time();
+
+  if (dt <= 0 || context()->sim_info().decay == "never") {
+    return;
+  }
+
+  double surviving = TritiumSurvival(dt * context()->dt());
+  for (int i = 0; i < n_plants; ++i) {
+    DecayStep(surviving, &storage_tritium[i], &storage_helium3[i]);
+    DecayStep(surviving, &excess_tritium[i], &excess_helium3[i]);
+    DecayStep(surviving, &sequestered_tritium[i], &sequestered_helium3[i]);
+  }
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void FusionFleet::ExtractHelium() {
+  double eps = cyclus::eps_rsrc();
+  for (int i = 0; i < n_plants; ++i) {
+    double from_storage = storage_helium3[i] > eps ? storage_helium3[i] : 0;
+    double from_excess = excess_helium3[i] > eps ? excess_helium3[i] : 0;
+    storage_helium3[i] -= from_storage;
+    excess_helium3[i] -= from_excess;
+    helium_excess[i] += from_storage + from_excess;
+  }
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void FusionFleet::OperatePlants() {
+  double eps = cyclus::eps_rsrc();
+  double turnover = BlanketTurnoverDue();
+
+  // Decide which plants operate and cycle their blankets. This is the only
+  // per-plant branching; what follows is plain arithmetic.
+  for (int i = 0; i < n_plants; ++i) {
+    operate[i] = 0;
+    if (!online[i]) {
+      continue;
+    }
+
+    double storage = storage_tritium[i] + storage_helium3[i] + storage_other[i];
+    bool started = sequestered_tritium[i] + sequestered_helium3[i] >= eps;
+    double gap = SequesteredGap(sequestered_equilibrium, sequestered_tritium[i]);
+    double required = RequiredStorage(started, gap, step_reserve,
+                                      tritium_startup_fraction,
+                                      fuel_usage_mass);
+    bool clean = cyclus::AlmostEq(storage_tritium[i], storage);
+    if (storage < required || !clean || blanket_feed[i] < turnover) {
+      continue;
+    }
+
+    operate[i] = 1;
+    if (refill_start[i] < 0) {
+      refill_start[i] = context()->time();
+    }
+    CycleBlanket(i);
+  }
+
+  // Every operating plant breeds the same amount, so the blankets can all
+  // be checked before anything is burned
+  double bred = fuel_usage_mass * TBR;
+  BreedingYield yield = Breeding(bred, Li7_contribution);
+  for (int i = 0; i < n_plants; ++i) {
+    if (operate[i] > 0 &&
+        (yield.li6 > blanket_li6[i] + eps || yield.li7 > blanket_li7[i] + eps)) {
+      std::stringstream ss;
+      ss << "plant " << i << " blanket holds " << blanket_li6[i]
+         << " kg Li-6 and " << blanket_li7[i] << " kg Li-7, cannot burn "
+         << yield.li6 << " kg and " << yield.li7 << " kg";
+      throw cyclus::ValueError(ss.str());
+    }
+  }
+
+  LoadCores(n_plants, operate.data(), sequestered_equilibrium, fuel_usage_mass,
+            bred, yield, eps, storage_tritium.data(), storage_helium3.data(),
+            storage_other.data(), sequestered_tritium.data(),
+            sequestered_helium3.data(), blanket_li6.data(), blanket_li7.data(),
+            blanket_he4.data());
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+double FusionFleet::BlanketTurnoverDue() {
+  int cycles = BlanketCycles(context()->time(),
+                             blanket_turnover_frequency * kDefaultTimeStepDur,
+                             context()->dt());
+  return BlanketTurnover(cycles, blanket_turnover, blanket_size);
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void FusionFleet::CycleBlanket(int i) {
+  double blanket =
+      blanket_li6[i] + blanket_li7[i] + blanket_he4[i] + blanket_rest[i];
+
+  double fill;
+  double turnover = BlanketTurnoverDue();
+  if (blanket < cyclus::eps_rsrc()) {
+    fill = std::min(blanket_size, blanket_feed[i]);
+  } else if (turnover > 0) {
+    double frac = std::min(turnover / blanket, 1.0);
+    double li6 = blanket_li6[i] * frac;
+    double li7 = blanket_li7[i] * frac;
+    double he4 = blanket_he4[i] * frac;
+    double rest = blanket_rest[i] * frac;
+
+    blanket_li6[i] -= li6;
+    blanket_li7[i] -= li7;
+    blanket_he4[i] -= he4;
+    blanket_rest[i] -= rest;
+    blanket_waste[i] += li6 + li7 + he4 + rest;
+
+    waste_mass[kLithium6Id] += li6;
+    waste_mass[kLithium7Id] += li7;
+    waste_mass[kHelium4Id] += he4;
+    for (CompMap::const_iterator it = feed_rest.begin(); it != feed_rest.end();
+         ++it) {
+      waste_mass[it->first] += rest * it->second;
+    }
+
+    fill = std::min(turnover, blanket_feed[i]);
+  } else {
+    return;
+  }
+
+  blanket_feed[i] -= fill;
+  blanket_li6[i] += fill * feed_li6_frac;
+  blanket_li7[i] += fill * feed_li7_frac;
+  blanket_he4[i] += fill * feed_he4_frac;
+  blanket_rest[i] += fill * (1 - feed_li6_frac - feed_li7_frac - feed_he4_frac);
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void FusionFleet::MoveExcess() {
+  for (int i = 0; i < n_plants; ++i) {
+    double storage = storage_tritium[i] + storage_helium3[i] + storage_other[i];
+    double gap = SequesteredGap(sequestered_equilibrium, sequestered_tritium[i]);
+    double excess = ExcessStorage(storage, step_reserve, gap);
+    if (excess <= cyclus::eps_rsrc()) {
+      continue;
+    }
+
+    double frac = std::min(excess / storage, 1.0);
+    double tritium = storage_tritium[i] * frac;
+    double helium3 = storage_helium3[i] * frac;
+    double other = storage_other[i] * frac;
+    storage_tritium[i] -= tritium;
+    storage_helium3[i] -= helium3;
+    storage_other[i] -= other;
+    excess_tritium[i] += tritium;
+    excess_helium3[i] += helium3;
+    excess_other[i] += other;
+  }
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+double FusionFleet::FuelDemand(int i) {
+  if (!online[i]) {
+    return 0;
+  }
+
+  double inventory =
+      storage_tritium[i] + storage_helium3[i] + storage_other[i];
+  double space = std::max(fuel_limit - inventory, 0.0);
+
+  // Startup policy: fill to the full startup inventory
+  if (refill_start[i] < 0) {
+    double startup = step_reserve + sequestered_equilibrium;
+    return inventory <= startup ? std::min(startup - inventory, space) : 0;
+  }
+
+  // Refill policy
+  if (refuel_mode == "schedule") {
+    bool active = (context()->time() - refill_start[i]) % buy_steps == 0;
+    return active ? std::min(step_buy_quantity, space) : 0;
+  }
+  return inventory <= step_reserve
+             ? std::min(step_reserve - inventory, space)
+             : 0;
+}
+
+double FusionFleet::BlanketDemand(int i) {
+  if (!online[i]) {
+    return 0;
+  }
+
+  double space = std::max(blanket_limit - blanket_feed[i], 0.0);
+  return blanket_feed[i] <= blanket_size
+             ? std::min(blanket_size - blanket_feed[i], space)
+             : 0;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+std::set<RequestPortfolio<Material>::Ptr> FusionFleet::GetMatlRequests() {
+  std::set<RequestPortfolio<Material>::Ptr> ports;
+
+  for (int i = 0; i < n_plants; ++i) {
+    fuel_request[i] = FuelDemand(i);
+    blanket_request[i] = BlanketDemand(i);
+  }
+
+  double fuel_demand = Sum(fuel_request);
+  if (fuel_demand > cyclus::eps_rsrc()) {
+    RequestPortfolio<Material>::Ptr port(new RequestPortfolio<Material>());
+    Material::Ptr target =
+        Material::CreateUntracked(fuel_demand, CompRegistry::Tritium());
+    port->AddRequest(target, this, fuel_incommod);
+    port->AddConstraint(CapacityConstraint<Material>(fuel_demand));
+    ports.insert(port);
+  }
+
+  double blanket_demand = Sum(blanket_request);
+  if (blanket_demand > cyclus::eps_rsrc()) {
+    RequestPortfolio<Material>::Ptr port(new RequestPortfolio<Material>());
+    // Same placeholder composition MatlBuyPolicy uses for a commodity
+    // without a recipe
+    CompMap any;
+    any[10010000] = 1e-100;
+    Material::Ptr target = Material::CreateUntracked(
+        blanket_demand, Composition::CreateFromMass(any));
+    port->AddRequest(target, this, blanket_incommod);
+    port->AddConstraint(CapacityConstraint<Material>(blanket_demand));
+    ports.insert(port);
+  }
+
+  return ports;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void FusionFleet::AcceptMatlTrades(
+    const std::vector<std::pair<Trade<Material>, Material::Ptr> >& responses) {
+  std::vector<std::pair<Trade<Material>, Material::Ptr> >::const_iterator it;
+  for (it = responses.begin(); it != responses.end(); ++it) {
+    std::string commod = it->first.request->commodity();
+    if (commod == fuel_incommod) {
+      ReceiveFuel(it->second);
+    } else if (commod == blanket_incommod) {
+      ReceiveBlanketFeed(it->second);
+    }
+  }
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void FusionFleet::ReceiveFuel(Material::Ptr mat) {
+  double qty = mat->quantity();
+  double demand = Sum(fuel_request);
+  if (qty <= 0 || demand <= 0) {
+    return;
+  }
+
+  CompMap fractions = MassFractions(mat->comp());
+  double tritium = fractions[kTritiumId];
+  double helium3 = fractions[kHelium3Id];
+  double other = std::max(1 - tritium - helium3, 0.0);
+
+  if (other > 0) {
+    // Fold the impurities into the fleet-average impurity composition
+    double held = Sum(storage_other) + Sum(excess_other);
+    double added = qty * other;
+    for (CompMap::iterator f = fuel_impurity.begin(); f != fuel_impurity.end();
+         ++f) {
+      f->second *= held / (held + added);
+    }
+    for (CompMap::const_iterator f = fractions.begin(); f != fractions.end();
+         ++f) {
+      if (f->first != kTritiumId && f->first != kHelium3Id) {
+        fuel_impurity[f->first] += f->second * qty / (held + added);
+      }
+    }
+  }
+
+  for (int i = 0; i < n_plants; ++i) {
+    double share = qty * fuel_request[i] / demand;
+    storage_tritium[i] += share * tritium;
+    storage_helium3[i] += share * helium3;
+    storage_other[i] += share * other;
+  }
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void FusionFleet::ReceiveBlanketFeed(Material::Ptr mat) {
+  double qty = mat->quantity();
+  double demand = Sum(blanket_request);
+  if (qty <= 0 || demand <= 0) {
+    return;
+  }
+
+  // Feed already held is assumed to have the same composition, so the
+  // incoming material is mixed into the fleet-wide feed fractions
+  double held = Sum(blanket_feed);
+  double w_held = held / (held + qty);
+  double w_new = qty / (held + qty);
+
+  // feed_rest is normalized to the non Li/He-4 part of the feed
+  double rest_held = held * (1 - feed_li6_frac - feed_li7_frac - feed_he4_frac);
+
+  CompMap fractions = MassFractions(mat->comp());
+  feed_li6_frac = feed_li6_frac * w_held + fractions[kLithium6Id] * w_new;
+  feed_li7_frac = feed_li7_frac * w_held + fractions[kLithium7Id] * w_new;
+  feed_he4_frac = feed_he4_frac * w_held + fractions[kHelium4Id] * w_new;
+
+  double rest_new = qty * (1 - fractions[kLithium6Id] -
+                           fractions[kLithium7Id] - fractions[kHelium4Id]);
+  if (rest_new > 0) {
+    CompMap rest;
+    for (CompMap::const_iterator f = feed_rest.begin(); f != feed_rest.end();
+         ++f) {
+      rest[f->first] += f->second * rest_held;
+    }
+    for (CompMap::const_iterator f = fractions.begin(); f != fractions.end();
+         ++f) {
+      if (f->first != kLithium6Id && f->first != kLithium7Id &&
+          f->first != kHelium4Id) {
+        rest[f->first] += f->second * qty;
+      }
+    }
+    for (CompMap::iterator f = rest.begin(); f != rest.end(); ++f) {
+      f->second /= rest_held + rest_new;
+    }
+    feed_rest = rest;
+  }
+
+  for (int i = 0; i < n_plants; ++i) {
+    blanket_feed[i] += qty * blanket_request[i] / demand;
+  }
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+Composition::Ptr FusionFleet::ExcessComp() {
+  CompMap mass;
+  double other = Sum(excess_other);
+  for (CompMap::const_iterator it = fuel_impurity.begin();
+       it != fuel_impurity.end(); ++it) {
+    mass[it->first] = it->second * other;
+  }
+  mass[kTritiumId] += Sum(excess_tritium);
+  mass[kHelium3Id] += Sum(excess_helium3);
+  return Composition::CreateFromMass(mass);
+}
+
+Composition::Ptr FusionFleet::WasteComp() {
+  return Composition::CreateFromMass(waste_mass);
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+std::set<BidPortfolio<Material>::Ptr> FusionFleet::GetMatlBids(
+    cyclus::CommodMap<Material>::type& commod_requests) {
+  std::set<BidPortfolio<Material>::Ptr> ports;
+
+  double excess =
+      Sum(excess_tritium) + Sum(excess_helium3) + Sum(excess_other);
+  if (excess > cyclus::eps_rsrc()) {
+    Offer(fuel_outcommod, excess, ExcessComp(), commod_requests, &ports);
+  }
+
+  double helium = Sum(helium_excess);
+  if (helium > cyclus::eps_rsrc()) {
+    Offer(he3_outcommod, helium, CompRegistry::Helium3(), commod_requests,
+          &ports);
+  }
+
+  double waste = Sum(blanket_waste);
+  if (waste > cyclus::eps_rsrc()) {
+    Offer(blanket_outcommod, waste, WasteComp(), commod_requests, &ports);
+  }
+
+  return ports;
+}
+
+void FusionFleet::Offer(
+    const std::string& commod, double available, Composition::Ptr comp,
+    cyclus::CommodMap<Material>::type& commod_requests,
+    std::set<BidPortfolio<Material>::Ptr>* ports) {
+  if (commod.empty() || commod_requests.count(commod) == 0) {
+    return;
+  }
+
+  BidPortfolio<Material>::Ptr port(new BidPortfolio<Material>());
+  std::vector<Request<Material>*>& requests = commod_requests[commod];
+  for (size_t i = 0; i < requests.size(); ++i) {
+    double qty = std::min(requests[i]->target()->quantity(), available);
+    port->AddBid(requests[i], Material::CreateUntracked(qty, comp), this);
+  }
+  port->AddConstraint(CapacityConstraint<Material>(available));
+  ports->insert(port);
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void FusionFleet::GetMatlTrades(
+    const std::vector<Trade<Material> >& trades,
+    std::vector<std::pair<Trade<Material>, Material::Ptr> >& responses) {
+  for (size_t t = 0; t < trades.size(); ++t) {
+    std::string commod = trades[t].request->commodity();
+    double qty = trades[t].amt;
+    Composition::Ptr comp;
+
+    // Every plant gives up the same fraction of its inventory
+    if (commod == fuel_outcommod) {
+      comp = ExcessComp();
+      double held =
+          Sum(excess_tritium) + Sum(excess_helium3) + Sum(excess_other);
+      double keep = held > 0 ? std::max(1 - qty / held, 0.0) : 0;
+      Scale(&excess_tritium, keep);
+      Scale(&excess_helium3, keep);
+      Scale(&excess_other, keep);
+    } else if (commod == he3_outcommod) {
+      comp = CompRegistry::Helium3();
+      double held = Sum(helium_excess);
+      Scale(&helium_excess, held > 0 ? std::max(1 - qty / held, 0.0) : 0);
+    } else if (commod == blanket_outcommod) {
+      comp = WasteComp();
+      double held = Sum(blanket_waste);
+      double keep = held > 0 ? std::max(1 - qty / held, 0.0) : 0;
+      Scale(&blanket_waste, keep);
+      for (CompMap::iterator it = waste_mass.begin(); it != waste_mass.end();
+           ++it) {
+        it->second *= keep;
+      }
+    } else {
+      continue;
+    }
+
+    responses.push_back(
+        std::make_pair(trades[t], Material::Create(this, qty, comp)));
+  }
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void FusionFleet::RecordInventories() {
+  for (int i = 0; i < n_plants; ++i) {
+    if (!online[i]) {
+      continue;
+    }
+
+    context()
+        ->NewDatum("FleetInventories")
+        ->AddVal("AgentId", id())
+        ->AddVal("PlantIndex", i)
+        ->AddVal("Time", context()->time())
+        ->AddVal("TritiumStorage",
+                 storage_tritium[i] + storage_helium3[i] + storage_other[i])
+        ->AddVal("TritiumExcess",
+                 excess_tritium[i] + excess_helium3[i] + excess_other[i])
+        ->AddVal("TritiumSequestered",
+                 sequestered_tritium[i] + sequestered_helium3[i])
+        ->AddVal("BlanketFeed", blanket_feed[i])
+        ->AddVal("BlanketWaste", blanket_waste[i])
+        ->AddVal("HeliumExcess", helium_excess[i])
+        ->Record();
+  }
+}
+
+// WARNING! Do not change the following this function!!! This enables your
+// archetype to be dynamically loaded and any alterations will cause your
+// archetype to fail.
+extern "C" cyclus::Agent* ConstructFusionFleet(cyclus::Context* ctx) {
+  return new FusionFleet(ctx);
+}
+
+}  // namespace tricycle
@@ -0,0 +1,420 @@
+#ifndef CYCLUS_TRICYCLE_FUSION_FLEET_H_
+#define CYCLUS_TRICYCLE_FUSION_FLEET_H_
+
+#include <map>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "cyclus.h"
+#include "nuclides.h"
+#include "plant_kernels.h"
+
+namespace tricycle {
+
+/// @class FusionFleet
+/// One agent standing in for a fleet of identical fusion power plants.
+///
+/// @section intro Introduction
+/// Deployment studies with thousands of FusionPowerPlant agents spend most
+/// of their time on agent bookkeeping: every plant owns five ResBufs, three
+/// buy policies and three sell policies. FusionFleet keeps the per-plant
+/// state (tritium storage, excess and sequestered tritium, blanket, startup
+/// status) in structure-of-arrays form and advances every plant with the
+/// same kernels FusionPowerPlant uses (plant_kernels.h). Towards the rest of
+/// the simulation the fleet is a single aggregated buyer and seller.
+///
+/// @section agentparams Agent Parameters
+/// All plant parameters are the FusionPowerPlant parameters of the same
+/// name, shared by every plant of the fleet. n_plants sets the fleet size,
+/// and plant_start_times optionally delays individual plants by a number of
+/// time steps after the fleet enters the simulation.
+///
+/// @section detailed Detailed Behavior
+/// Each plant follows FusionPowerPlant::Tick exactly: decay, helium-3
+/// extraction, the startup/operation check, core loading, breeding and the
+/// move of surplus tritium to the excess inventory. Demand is the sum of
+/// what each plant's startup, refill and blanket policies would request;
+/// deliveries are split between plants in proportion to their demand.
+/// Sales draw every plant's excess, helium-3 or blanket waste down by the
+/// same fraction. Tritium in the core is consumed within the time step, so
+/// it is not kept between steps.
+///
+/// Per-plant inventories are recorded in the FleetInventories table, with
+/// the same columns as FPPInventories plus the plant index.
+///
+/// Nuclides other than tritium and helium-3 delivered as fuel are carried
+/// as inert mass with the fleet-average impurity composition, and every
+/// plant is assumed to receive blanket feed of the same composition.
+class FusionFleet : public cyclus::Facility {
+ public:
+  /// Constructor for FusionFleet Class
+  /// @param ctx the cyclus context for access to simulation-wide parameters
+  explicit FusionFleet(cyclus::Context* ctx);
+
+  #pragma cyclus
+
+  #pragma cyclus note {"doc": "A fleet of identical fusion power plants " \
+                              "simulated and traded as a single agent."}
+
+  virtual ~FusionFleet() {}
+
+  /// Sizes the per-plant arrays and derives the per-step fuel usage
+  virtual void EnterNotify();
+
+  /// Advances every commissioned plant by one time step
+  virtual void Tick();
+
+  /// Records per-plant inventories
+  virtual void Tock();
+
+  /// A verbose printer for the FusionFleet
+  virtual std::string str();
+
+  /// Requests the fleet's total tritium and blanket feed demand
+  virtual std::set<cyclus::RequestPortfolio<cyclus::Material>::Ptr>
+  GetMatlRequests();
+
+  /// Splits delivered tritium and blanket feed between the plants
+  virtual void AcceptMatlTrades(
+      const std::vector<std::pair<cyclus::Trade<cyclus::Material>,
+                                  cyclus::Material::Ptr> >& responses);
+
+  /// Offers the fleet's pooled excess tritium, helium-3 and blanket waste
+  virtual std::set<cyclus::BidPortfolio<cyclus::Material>::Ptr> GetMatlBids(
+      cyclus::CommodMap<cyclus::Material>::type& commod_requests);
+
+  /// Draws traded material out of the plants' inventories
+  virtual void GetMatlTrades(
+      const std::vector<cyclus::Trade<cyclus::Material> >& trades,
+      std::vector<std::pair<cyclus::Trade<cyclus::Material>,
+                            cyclus::Material::Ptr> >& responses);
+
+  // State Variables:
+  #pragma cyclus var { \
+    "doc": "Number of plants in the fleet", \
+    "tooltip": "Number of plants", \
+    "uitype": "range", \
+    "range": [0, 1e9], \
+    "uilabel": "Fleet Size" \
+  }
+  int n_plants;
+
+  #pragma cyclus var { \
+    "default": [], \
+    "doc": "Time steps after the fleet enters the simulation at which each " \
+           "plant comes online. Plants without an entry start immediately.", \
+    "tooltip": "Per-plant startup delays", \
+    "units": "Timesteps", \
+    "uilabel": "Plant Start Times" \
+  }
+  std::vector<int> plant_start_times;
+
+  #pragma cyclus var { \
+    "doc": "Nameplate fusion power of each reactor", \
+    "tooltip": "Nameplate fusion power", \
+    "units": "MW", \
+    "uitype": "range", \
+    "range": [0, 1e299], \
+    "uilabel": "Fusion Power" \
+  }
+  double fusion_power;
+
+  #pragma cyclus var { \
+    "doc": "Achievable system tritium breeding ratio before decay", \
+    "tooltip": "Achievable system tritium breeding ratio before decay", \
+    "units": "non-dimensional", \
+    "uitype": "range", \
+    "range": [0, 1e299], \
+    "uilabel": "Tritium Breeding Ratio" \
+  }
+  double TBR;
+
+  #pragma cyclus var { \
+    "doc": "Minimum tritium inventory each plant holds in reserve in case of tritium recovery system failure", \
+    "tooltip": "Minimum tritium inventory to hold in reserve", \
+    "units": "kg", \
+    "uilabel": "Reserve Inventory" \
+  }
+  double reserve_inventory;
+
+  #pragma cyclus var { \
+    "doc": "Equilibrium quantity of tritium which is sequestered in each plant and no longer accessible", \
+    "tooltip": "sequestered tritium equilibrium quantity", \
+    "units": "kg", \
+    "uilabel": "Equilibrium Quantity of Sequestered Tritium" \
+  }
+  double sequestered_equilibrium;
+
+  #pragma cyclus var { \
+    "default": 0.9, \
+    "doc": "Fraction of desired startup ( = reserve + sequestered) tritium inventory required for initial startup. ", \
+    "tooltip": "Fraction of reserve required for startup", \
+    "units": "dimensionless", \
+    "range": [0, 1], \
+    "uilabel": "Tritium Startup Fraction" \
+  }
+  double tritium_startup_fraction;
+
+  #pragma cyclus var { \
+    "doc": "Fresh fuel commodity", \
+    "tooltip": "Name of fuel commodity requested", \
+    "uilabel": "Fuel input commodity" \
+  }
+  std::string fuel_incommod;
+
+  #pragma cyclus var { "default":"",\
+    "doc": "Fuel commodity leaving the fleet", \
+    "tooltip": "Name of fuel commodity offered", \
+    "uilabel": "Fuel output commodity" \
+  }
+  std::string fuel_outcommod;
+
+  #pragma cyclus var { \
+    "default": 0.03, \
+    "doc": "Fraction of tritium that comes from the (n + Li-7 --> T + He + n) reaction", \
+    "tooltip": "Fraction of tritium from Li-7 breeding", \
+    "units": "dimensionless", \
+    "uitype": "range", \
+    "range": [0, 1], \
+    "uilabel": "Li-7 Contribution" \
+  }
+  double Li7_contribution;
+
+  #pragma cyclus var { \
+    "default": 'fill', \
+    "doc": "Method of refueling the reactors", \
+    "tooltip": "Options: 'schedule' or 'fill'", \
+    "uitype": "combobox", \
+    "categorical": ['schedule', 'fill'], \
+    "uilabel": "Refuel Mode" \
+  }
+  std::string refuel_mode;
+
+  #pragma cyclus var { \
+    "default": 0.1, \
+    "doc": "Quantity of fuel each reactor tries to purchase in schedule mode", \
+    "tooltip": "Defaults to 100g/purchase", \
+    "units": "kg", \
+    "uitype": "range", \
+    "range": [0, 1e299], \
+    "uilabel": "Buy quantity" \
+  }
+  double buy_quantity;
+
+  #pragma cyclus var { \
+    "default": 1, \
+    "doc": "Months between fuel purchases of each reactor in schedule mode, rounded to whole time steps. If a time step is longer, each purchase covers all the periods in it.", \
+    "tooltip": "Each reactor buys once every buy_frequency months", \
+    "units": "months", \
+    "uitype": "range", \
+    "range": [1, 1e299], \
+    "uilabel": "Buy frequency" \
+  }
+  int buy_frequency;
+
+  #pragma cyclus var { \
+    "doc": "Helium-3 output commodity Designation", \
+    "tooltip": "He-3 output commodity", \
+    "uilabel": "He-3 output commodity" \
+  }
+  std::string he3_outcommod;
+
+  #pragma cyclus var { \
+    "doc": "Blanket feed commodity designation", \
+    "tooltip": "Blanket feed commodity", \
+    "uilabel": "Blanket feed commodity" \
+  }
+  std::string blanket_incommod;
+
+  #pragma cyclus var { \
+    "doc": "Blanket waste commodity designation", \
+    "tooltip": "Blanket waste commodity", \
+    "uilabel": "Blanket waste commodity" \
+  }
+  std::string blanket_outcommod;
+
+  #pragma cyclus var { \
+    "default": 1000.0, \
+    "doc": "Initial mass of full blanket material of each plant", \
+    "tooltip": "Only blanket material mass, not structural mass", \
+    "units": "kg", \
+    "uitype": "range", \
+    "range": [0, 10000], \
+    "uilabel": "Initial Mass of Blanket" \
+  }
+  double blanket_size;
+
+  #pragma cyclus var { \
+    "default": 0.05, \
+    "doc": "Percent of blanket that gets recycled every blanket turnover period", \
+    "tooltip": "Defaults to 0.05 (5%), must be between 0 and 15%", \
+    "units": "dimensionless", \
+    "uitype": "range", \
+    "range": [0, 0.15], \
+    "uilabel": "Blanket Turnover Rate" \
+  }
+  double blanket_turnover_fraction;
+
+  #pragma cyclus var { \
+    "default": 1, \
+    "doc": "Months between blanket recycles. Time steps spanning several turnover periods recycle blanket_turnover_fraction of the blanket for each of them.", \
+    "tooltip": "Months between blanket recycles", \
+    "units": "months", \
+    "uitype": "range", \
+    "range": [0, 1000], \
+    "uilabel": "Blanket Turnover Frequency" \
+  }
+  int blanket_turnover_frequency;
+
+ private:
+  /// Marks the plants that are commissioned by the current time step
+  void UpdateOnline();
+
+  void DecayInventories();
+  void ExtractHelium();
+  void OperatePlants();
+  void MoveExcess();
+  void CycleBlanket(int i);
+  /// Blanket mass each plant swaps out this time step, 0 if none is due
+  double BlanketTurnoverDue();
+  void RecordInventories();
+
+  /// Tritium and blanket feed plant i would request this time step
+  double FuelDemand(int i);
+  double BlanketDemand(int i);
+
+  /// Splits a delivery between the plants in proportion to demand
+  void ReceiveFuel(cyclus::Material::Ptr mat);
+  void ReceiveBlanketFeed(cyclus::Material::Ptr mat);
+
+  /// Adds a bid portfolio offering up to available kg of comp on commod
+  void Offer(const std::string& commod, double available,
+             cyclus::Composition::Ptr comp,
+             cyclus::CommodMap<cyclus::Material>::type& commod_requests,
+             std::set<cyclus::BidPortfolio<cyclus::Material>::Ptr>* ports);
+
+  /// Fleet-wide compositions of the pooled sale inventories
+  cyclus::Composition::Ptr ExcessComp();
+  cyclus::Composition::Ptr WasteComp();
+
+  // Per-plant state, one entry per plant (kg unless noted). It is saved
+  // with the agent, so that a fleet can be restarted.
+  #pragma cyclus var {"default": [], "internal": True, \
+                      "doc": "Tritium in each plant's storage (internal state)"}
+  std::vector<double> storage_tritium;
+  #pragma cyclus var {"default": [], "internal": True, \
+                      "doc": "Helium-3 in each plant's storage (internal state)"}
+  std::vector<double> storage_helium3;
+  #pragma cyclus var {"default": [], "internal": True, \
+                      "doc": "Impurities in each plant's storage (internal state)"}
+  std::vector<double> storage_other;
+  #pragma cyclus var {"default": [], "internal": True, \
+                      "doc": "Excess tritium of each plant (internal state)"}
+  std::vector<double> excess_tritium;
+  #pragma cyclus var {"default": [], "internal": True, \
+                      "doc": "Helium-3 in each plant's excess (internal state)"}
+  std::vector<double> excess_helium3;
+  #pragma cyclus var {"default": [], "internal": True, \
+                      "doc": "Impurities in each plant's excess (internal state)"}
+  std::vector<double> excess_other;
+  #pragma cyclus var {"default": [], "internal": True, \
+                      "doc": "Sequestered tritium of each plant (internal state)"}
+  std::vector<double> sequestered_tritium;
+  #pragma cyclus var {"default": [], "internal": True, \
+                      "doc": "Helium-3 in each plant's sequestered tritium "\
+                             "(internal state)"}
+  std::vector<double> sequestered_helium3;
+  #pragma cyclus var {"default": [], "internal": True, \
+                      "doc": "Extracted helium-3 of each plant (internal state)"}
+  std::vector<double> helium_excess;
+  #pragma cyclus var {"default": [], "internal": True, \
+                      "doc": "Blanket feed held by each plant (internal state)"}
+  std::vector<double> blanket_feed;
+  #pragma cyclus var {"default": [], "internal": True, \
+                      "doc": "Li-6 in each plant's blanket (internal state)"}
+  std::vector<double> blanket_li6;
+  #pragma cyclus var {"default": [], "internal": True, \
+                      "doc": "Li-7 in each plant's blanket (internal state)"}
+  std::vector<double> blanket_li7;
+  #pragma cyclus var {"default": [], "internal": True, \
+                      "doc": "He-4 in each plant's blanket (internal state)"}
+  std::vector<double> blanket_he4;
+  #pragma cyclus var {"default": [], "internal": True, \
+                      "doc": "Other nuclides in each plant's blanket "\
+                             "(internal state)"}
+  std::vector<double> blanket_rest;
+  #pragma cyclus var {"default": [], "internal": True, \
+                      "doc": "Blanket waste held by each plant (internal state)"}
+  std::vector<double> blanket_waste;
+  /// Time step at which the refill policy took over, -1 before startup
+  #pragma cyclus var {"default": [], "internal": True, \
+                      "doc": "Time step each plant started at, -1 before "\
+                             "startup (internal state)"}
+  std::vector<int> refill_start;
+
+  // Per-plant scratch space, rebuilt every time step:
+  /// 1 for plants commissioned by the current time step, 0 otherwise
+  std::vector<char> online;
+  /// 1 for plants operating this time step, 0 otherwise, as a factor on
+  /// their burn and breeding
+  std::vector<double> operate;
+  /// Demand posted in the current exchange, used to split deliveries
+  std::vector<double> fuel_request;
+  std::vector<double> blanket_request;
+
+  // Fleet-wide compositions (mass fractions):
+  /// Non T/He-3 nuclides delivered as fuel
+  #pragma cyclus var {"default": {}, "internal": True, \
+                      "doc": "Composition of the fuel impurities "\
+                             "(internal state)"}
+  std::map<int, double> fuel_impurity;
+  /// Blanket feed, split into Li-6, Li-7, He-4 and everything else
+  #pragma cyclus var {"default": 0.0, "internal": True, \
+                      "doc": "Li-6 fraction of the blanket feed "\
+                             "(internal state)"}
+  double feed_li6_frac;
+  #pragma cyclus var {"default": 0.0, "internal": True, \
+                      "doc": "Li-7 fraction of the blanket feed "\
+                             "(internal state)"}
+  double feed_li7_frac;
+  #pragma cyclus var {"default": 0.0, "internal": True, \
+                      "doc": "He-4 fraction of the blanket feed "\
+                             "(internal state)"}
+  double feed_he4_frac;
+  #pragma cyclus var {"default": {}, "internal": True, \
+                      "doc": "Composition of the rest of the blanket feed "\
+                             "(internal state)"}
+  std::map<int, double> feed_rest;
+  /// Nuclide masses of all blanket waste held by the fleet
+  #pragma cyclus var {"default": {}, "internal": True, \
+                      "doc": "Nuclide masses of the blanket waste "\
+                             "(internal state)"}
+  std::map<int, double> waste_mass;
+
+  double blanket_turnover;
+  double fuel_usage_mass;
+  /// reserve_inventory, raised to one time step's burn where that is more
+  double step_reserve;
+  /// buy_frequency and buy_quantity scaled to whole time steps
+  int buy_steps;
+  double step_buy_quantity;
+
+  //This mirrors the FusionPowerPlant TotalInvTracker capacities
+  double fuel_limit = 1000.0;
+  double blanket_limit = 100000.0;
+
+  // Last time the tritium inventories were decayed
+  #pragma cyclus var {"default": 0, "internal": True, \
+                      "doc": "Time the tritium inventories were last decayed "\
+                             "(internal state)"}
+  int decay_time;
+
+  // Constants
+  static const double burn_rate; // kg/GW-y
+};
+
+}  // namespace tricycle
+
+#endif  // CYCLUS_TRICYCLE_FUSION_FLEET_H_
@@ -0,0 +1,205 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "agent_tests.h"
+#include "context.h"
+#include "facility_tests.h"
+#include "fusion_fleet.h"
+#include "pyhooks.h"
+
+using cyclus::Cond;
+using cyclus::QueryResult;
+
+namespace tricycle {
+namespace {
+
+cyclus::Composition::Ptr pure_tritium() {
+  cyclus::CompMap m;
+  m[10030000] = 1.0;
+  return cyclus::Composition::CreateFromAtom(m);
+}
+
+cyclus::Composition::Ptr lithium_feed() {
+  cyclus::CompMap m;
+  m[30060000] = 0.3;
+  m[30070000] = 0.7;
+  return cyclus::Composition::CreateFromAtom(m);
+}
+
+// Plant parameters shared by FusionPowerPlant and FusionFleet
+std::string plant_config =
+    " <fusion_power>300</fusion_power>"
+    " <TBR>1.08</TBR>"
+    " <reserve_inventory>6.0</reserve_inventory>"
+    " <sequestered_equilibrium>2.121</sequestered_equilibrium>"
+    " <fuel_incommod>Tritium</fuel_incommod>"
+    " <blanket_incommod>Enriched_Lithium</blanket_incommod>"
+    " <blanket_outcommod>Depleted_Lithium</blanket_outcommod>"
+    " <blanket_size>1000</blanket_size>"
+    " <blanket_turnover_fraction>0.03</blanket_turnover_fraction>"
+    " <he3_outcommod>Helium_3</he3_outcommod>";
+
+cyclus::MockSim InitializeSim(std::string archetype, std::string config,
+                              int simdur) {
+  cyclus::MockSim sim(cyclus::AgentSpec(archetype), config, simdur);
+
+  sim.AddRecipe("tritium", pure_tritium());
+  sim.AddRecipe("enriched_lithium", lithium_feed());
+  sim.AddSource("Enriched_Lithium").recipe("enriched_lithium").Finalize();
+  sim.AddSource("Tritium").recipe("tritium").Finalize();
+
+  return sim;
+}
+
+QueryResult PlantInventoryQuery(cyclus::MockSim& sim, std::string time,
+                                std::string plant) {
+  std::vector<Cond> conds;
+  conds.push_back(Cond("Time", "==", time));
+  conds.push_back(Cond("PlantIndex", "==", plant));
+  return sim.db().Query("FleetInventories", &conds);
+}
+
+}  // namespace
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+TEST(FusionFleetTest, MatchesIndividualPlants) {
+  // Every plant of a fleet that is never short of fuel or feed must follow
+  // a lone FusionPowerPlant with the same parameters.
+  int simdur = 12;
+
+  cyclus::MockSim plant_sim =
+      InitializeSim(":tricycle:FusionPowerPlant",
+                    plant_config +
+                        " <blanket_inrecipe>enriched_lithium</blanket_inrecipe>",
+                    simdur);
+  plant_sim.Run();
+
+  cyclus::MockSim fleet_sim = InitializeSim(
+      ":tricycle:FusionFleet", plant_config + " <n_plants>3</n_plants>",
+      simdur);
+  fleet_sim.Run();
+
+  std::vector<std::string> columns = {"TritiumStorage", "TritiumExcess",
+                                      "TritiumSequestered", "BlanketFeed",
+                                      "BlanketWaste", "HeliumExcess"};
+
+  for (std::string time : {"0", "1", "6", "11"}) {
+    std::vector<Cond> conds;
+    conds.push_back(Cond("Time", "==", time));
+    QueryResult expected = plant_sim.db().Query("FPPInventories", &conds);
+
+    for (std::string plant : {"0", "1", "2"}) {
+      QueryResult actual = PlantInventoryQuery(fleet_sim, time, plant);
+      for (const std::string& column : columns) {
+        EXPECT_NEAR(expected.GetVal<double>(column),
+                    actual.GetVal<double>(column), 1e-9)
+            << column << " of plant " << plant << " at time " << time;
+      }
+    }
+  }
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+TEST(FusionFleetTest, ScheduleMatchesIndividualPlants) {
+  // In schedule mode every plant of a fleet buys on the same time steps and
+  // the same quantities as a lone FusionPowerPlant. Both take buy_frequency
+  // in months and scale it to the time step through the same kernels, so
+  // this also holds on non-monthly steps (see PlantKernelsTest).
+  int simdur = 12;
+  std::string schedule = " <refuel_mode>schedule</refuel_mode>"
+                         " <buy_quantity>5</buy_quantity>"
+                         " <buy_frequency>3</buy_frequency>";
+
+  cyclus::MockSim plant_sim =
+      InitializeSim(":tricycle:FusionPowerPlant",
+                    plant_config + schedule +
+                        " <blanket_inrecipe>enriched_lithium</blanket_inrecipe>",
+                    simdur);
+  plant_sim.Run();
+
+  cyclus::MockSim fleet_sim = InitializeSim(
+      ":tricycle:FusionFleet",
+      plant_config + schedule + " <n_plants>2</n_plants>", simdur);
+  fleet_sim.Run();
+
+  std::vector<std::string> columns = {"TritiumStorage", "TritiumExcess",
+                                      "TritiumSequestered"};
+  for (int t = 0; t < simdur; ++t) {
+    std::string time = std::to_string(t);
+    std::vector<Cond> conds;
+    conds.push_back(Cond("Time", "==", time));
+    QueryResult expected = plant_sim.db().Query("FPPInventories", &conds);
+
+    for (std::string plant : {"0", "1"}) {
+      QueryResult actual = PlantInventoryQuery(fleet_sim, time, plant);
+      for (const std::string& column : columns) {
+        EXPECT_NEAR(expected.GetVal<double>(column),
+                    actual.GetVal<double>(column), 1e-9)
+            << column << " of plant " << plant << " at time " << time;
+      }
+    }
+  }
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+TEST(FusionFleetTest, StaggeredStart) {
+  // A plant only appears, requests fuel and operates once it comes online
+  std::string config = plant_config +
+                       " <n_plants>2</n_plants>"
+                       " <plant_start_times><val>0</val><val>3</val>"
+                       "</plant_start_times>";
+
+  int simdur = 5;
+  cyclus::MockSim sim = InitializeSim(":tricycle:FusionFleet", config, simdur);
+  sim.Run();
+
+  std::vector<Cond> conds;
+  conds.push_back(Cond("PlantIndex", "==", std::string("1")));
+  QueryResult late = sim.db().Query("FleetInventories", &conds);
+  EXPECT_EQ(2, late.rows.size());
+
+  QueryResult first = PlantInventoryQuery(sim, "0", "0");
+  QueryResult second = PlantInventoryQuery(sim, "3", "1");
+  EXPECT_DOUBLE_EQ(first.GetVal<double>("TritiumSequestered"),
+                   second.GetVal<double>("TritiumSequestered"));
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+TEST(FusionFleetTest, PooledExcessSale) {
+  // Excess tritium of the whole fleet is sold through one offer
+  std::string config = plant_config +
+                       " <n_plants>4</n_plants>"
+                       " <fuel_outcommod>TritiumFromFleet</fuel_outcommod>";
+
+  int simdur = 10;
+  cyclus::MockSim sim = InitializeSim(":tricycle:FusionFleet", config, simdur);
+  sim.AddSink("TritiumFromFleet").Finalize();
+  sim.Run();
+
+  std::vector<Cond> conds;
+  conds.push_back(Cond("TritiumExcess", ">", std::string("0")));
+  QueryResult qr = sim.db().Query("FleetInventories", &conds);
+  EXPECT_EQ(0, qr.rows.size());
+
+  std::vector<Cond> sold;
+  sold.push_back(Cond("Commodity", "==", std::string("TritiumFromFleet")));
+  EXPECT_LT(0, sim.db().Query("Transactions", &sold).rows.size());
+}
+
+}  // namespace tricycle
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// Do Not Touch! Below section required for connection with Cyclus
+cyclus::Agent* FusionFleetConstructor(cyclus::Context* ctx) {
+  return new tricycle::FusionFleet(ctx);
+}
+// Required to get functionality in cyclus agent unit tests library
+#ifndef CYCLUS_AGENT_TESTS_CONNECTED
+int ConnectAgentTests();
+static int cyclus_agent_tests_connected = ConnectAgentTests();
+#define CYCLUS_AGENT_TESTS_CONNECTED cyclus_agent_tests_connected
+#endif  // CYCLUS_AGENT_TESTS_CONNECTED
+INSTANTIATE_TEST_CASE_P(FusionFleet, FacilityTests,
+                        ::testing::Values(&FusionFleetConstructor));
@@ -2,10 +2,6 @@
 
 using cyclus::CompMap;
 using cyclus::Composition;
-using cyclus::DoubleDistribution;
-using cyclus::FixedDoubleDist;
-using cyclus::FixedIntDist;
-using cyclus::IntDistribution;
 using cyclus::KeyError;
 using cyclus::Material;
 using cyclus::toolkit::ResBuf;
@@ -20,12 +16,51 @@ FusionPowerPlant::FusionPowerPlant(cyclus::Context* ctx)
     : cyclus::Facility(ctx) {
   fuel_tracker.Init({&tritium_storage}, fuel_limit);
   blanket_tracker.Init({&blanket_feed}, blanket_limit);
+  forecast_tracker.Init({&tritium_storage}, fuel_limit);
 
   tritium_storage = ResBuf<Material>(true);
   tritium_excess = ResBuf<Material>(true);
   helium_excess = ResBuf<Material>(true);
   blanket_feed = ResBuf<Material>(true);
   blanket_waste = ResBuf<Material>(true);
+
+  storage_inventory.Init(&tritium_storage);
+  excess_inventory.Init(&tritium_excess);
+
+  blanket_turnover = 0;
+  fuel_usage_mass = 0;
+  step_reserve = 0;
+  decay_time = 0;
+  recorded_operating = false;
+  started_up = false;
+  refill_start = -1;
+  quiescent = false;
+
+  forecast_horizon = 12;
+  track_internal_flows = true;
+  record_dre = false;
+  prune_exchange = false;
+  quiescent_mode = false;
+  record_sensitivities = false;
+  prune_threshold = 0;
+
+  record_stride = 1;
+  record_tolerance = 0;
+  InitRecorder();
+  perf.Init(this);
+  dre.Init(this);
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void FusionPowerPlant::InitRecorder() {
+  recorder.Init(this, "FPPInventories",
+                {"TritiumStorage", "TritiumExcess", "TritiumSequestered",
+                 "BlanketFeed", "BlanketWaste", "HeliumExcess"},
+                record_stride, record_tolerance);
+  if (record_sensitivities) {
+    sensitivity_recorder.Init(this, "FPPSensitivities",
+                              PlantSensitivity::Columns(), record_stride);
+  }
 }
 
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
@@ -40,18 +75,24 @@ void FusionPowerPlant::EnterNotify() {
   fuel_usage_mass = (burn_rate * (fusion_power / MW_to_GW) /
                      (kDefaultTimeStepDur * 12) * context()->dt());
   blanket_turnover = blanket_size * blanket_turnover_fraction;
+  step_reserve = StepReserve(reserve_inventory, fuel_usage_mass);
+  sensitivity.Init(TBR, step_reserve, Li7_contribution, burn_rate,
+                   fuel_usage_mass, sequestered_equilibrium);
 
-  // Create the blanket material for use in the core, no idea if this works...
-  blanket = Material::Create(this, 0.0, context()->GetRecipe(blanket_inrecipe));
+  InitRecorder();
 
   fuel_startup_policy
       .Init(this, &tritium_storage, std::string("Tritium Storage"),
             &fuel_tracker, std::string("ss"),
-            reserve_inventory + sequestered_equilibrium,
-            reserve_inventory + sequestered_equilibrium)
-      .Set(fuel_incommod, tritium_comp)
+            step_reserve + sequestered_equilibrium,
+            step_reserve + sequestered_equilibrium)
+      .Set(fuel_incommod, CompRegistry::Tritium())
       .Start();
 
+  // The blanket is modelled from whatever is delivered on blanket_incommod,
+  // but a misspelled recipe still fails here rather than passing silently
+  context()->GetRecipe(blanket_inrecipe);
+
   blanket_fill_policy
       .Init(this, &blanket_feed, std::string("Blanket Startup"),
             &blanket_tracker, std::string("ss"), blanket_size, blanket_size)
@@ -60,26 +101,47 @@ void FusionPowerPlant::EnterNotify() {
 
   // Tritium Buy Policy Selection:
   if (refuel_mode == "schedule") {
-    IntDistribution::Ptr active_dist = FixedIntDist::Ptr(new FixedIntDist(1));
-    IntDistribution::Ptr dormant_dist =
-        FixedIntDist::Ptr(new FixedIntDist(buy_frequency - 1));
-    DoubleDistribution::Ptr size_dist =
-        FixedDoubleDist::Ptr(new FixedDoubleDist(1));
+    if (buy_frequency < 1) {
+      throw cyclus::ValueError("buy_frequency must be at least 1");
+    }
+    // A purchase every buy_frequency months, rounded to whole time steps and
+    // counted from the time step the refill policy took over, which is
+    // saved so that a restart keeps the schedule. Time steps longer than
+    // that buy for all the periods they cover.
+    double period = buy_frequency * kDefaultTimeStepDur;
+    int buy_steps = PeriodSteps(period, context()->dt());
+    double quantity =
+        ScheduledQuantity(buy_quantity, period, buy_steps, context()->dt());
 
     fuel_refill_policy
         .Init(this, &tritium_storage, std::string("Input"), &fuel_tracker,
-              buy_quantity, active_dist, dormant_dist, size_dist)
-        .Set(fuel_incommod, tritium_comp);
+              quantity)
+        .Set(fuel_incommod, CompRegistry::Tritium());
+    fuel_refill_policy.Schedule([this, buy_steps]() {
+      return (context()->time() - refill_start) % buy_steps == 0;
+    });
 
   } else if (refuel_mode == "fill") {
     fuel_refill_policy
         .Init(this, &tritium_storage, std::string("Input"), &fuel_tracker,
-              std::string("ss"), reserve_inventory, reserve_inventory)
-        .Set(fuel_incommod, tritium_comp);
+              std::string("ss"), step_reserve, step_reserve)
+        .Set(fuel_incommod, CompRegistry::Tritium());
+
+  } else if (refuel_mode == "forecast") {
+    if (forecast_horizon < 1) {
+      throw cyclus::ValueError("forecast_horizon must be at least 1");
+    }
+    // Purchases are sized in MoveExcess through forecast_tracker's capacity.
+    // Until then nothing is bought, but a restarted plant may already hold
+    // fuel.
+    fuel_refill_policy
+        .Init(this, &tritium_storage, std::string("Input"), &forecast_tracker)
+        .Set(fuel_incommod, CompRegistry::Tritium());
+    forecast_tracker.set_capacity(tritium_storage.quantity());
 
   } else {
     throw KeyError("Refuel mode " + refuel_mode +
-                   " not recognized! Try 'schedule' or 'fill'.");
+                   " not recognized! Try 'schedule', 'fill' or 'forecast'.");
   }
 
   tritium_sell_policy.Init(this, &tritium_excess, std::string("Excess Tritium"))
@@ -94,48 +156,305 @@ void FusionPowerPlant::EnterNotify() {
       .Init(this, &blanket_waste, std::string("Blanket Waste"))
       .Set(blanket_outcommod)
       .Start();
+
+  if (record_dre) {
+    fuel_startup_policy.Count(&dre, "Fuel Startup");
+    fuel_refill_policy.Count(&dre, "Fuel Refill");
+    blanket_fill_policy.Count(&dre, "Blanket Fill");
+    tritium_sell_policy.Count(&dre, "Excess Tritium");
+    helium_sell_policy.Count(&dre, "Helium-3");
+    blanket_waste_sell_policy.Count(&dre, "Blanket Waste");
+  }
+
+  if (prune_exchange) {
+    PrunePolicies();
+  }
+
+  // A restarted plant that already runs only tops its fuel up
+  RestoreState();
+  if (started_up || sequestered_tritium.quantity() != 0) {
+    StartRefill();
+  }
+
+  if (!track_internal_flows) {
+    storage_inventory.set_tracked(false);
+    excess_inventory.set_tracked(false);
+
+    // Material restored on restart is tracked, everything the plant adds
+    // later is not. Deliveries of blanket feed are untracked on arrival.
+    Untrack(&tritium_storage);
+    Untrack(&tritium_excess);
+    Untrack(&blanket_feed);
+    Untrack(&helium_excess);
+    Untrack(&blanket_waste);
+    blanket_fill_policy.ObserveDeliveries(
+        [this](double) { Untrack(&blanket_feed); });
+
+    // Material only becomes a tracked resource once it is actually sold
+    tritium_sell_policy.ObserveTrades(
+        [this]() { tritium_lot.Open(&tritium_excess, this); });
+    tritium_sell_policy.ObserveShipments(
+        [this](double) { tritium_lot.Close(&tritium_excess); });
+    helium_sell_policy.ObserveTrades(
+        [this]() { helium_lot.Open(&helium_excess, this); });
+    helium_sell_policy.ObserveShipments(
+        [this](double) { helium_lot.Close(&helium_excess); });
+    blanket_waste_sell_policy.ObserveTrades(
+        [this]() { blanket_waste_lot.Open(&blanket_waste, this); });
+    blanket_waste_sell_policy.ObserveShipments(
+        [this](double) { blanket_waste_lot.Close(&blanket_waste); });
+  }
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void FusionPowerPlant::PrunePolicies() {
+  // Startup fuel is only asked for before the plant first runs, refill fuel
+  // only after. A plant that has run stays started up even if its
+  // sequestered tritium runs out.
+  fuel_startup_policy.Prune(prune_threshold,
+                            [this]() { return !started_up; });
+  fuel_refill_policy.Prune(prune_threshold, [this]() { return started_up; });
+  blanket_fill_policy.Prune(prune_threshold, [this]() {
+    return blanket_size - blanket_feed.quantity() > prune_threshold;
+  });
+
+  tritium_sell_policy.Prune(prune_threshold, [this]() {
+    return tritium_excess.quantity() > prune_threshold;
+  });
+  helium_sell_policy.Prune(prune_threshold, [this]() {
+    return helium_excess.quantity() > prune_threshold;
+  });
+  blanket_waste_sell_policy.Prune(prune_threshold, [this]() {
+    return blanket_waste.quantity() > prune_threshold;
+  });
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void FusionPowerPlant::StartRefill() {
+  if (!started_up || refill_start < 0) {
+    started_up = true;
+    refill_start = context()->time();
+  }
+  fuel_startup_policy.Stop();
+  fuel_refill_policy.Start();
 }
 
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 void FusionPowerPlant::Tick() {
+  TRICYCLE_PERF_SCOPE(perf, "Tick");
+
+  // A plant waiting for its startup inventory with no tritium to decay has
+  // nothing to do until the exchange moves something in or out. The decay
+  // time is kept current so that whatever arrives is only decayed from the
+  // time step it was delivered on.
+  idle_tick = quiescent && BufferQuantities() == idle_quantities;
+  if (idle_tick) {
+    decay_time = context()->time();
+    return;
+  }
 
-  DecayInventories();
-  ExtractHelium();
+  // Pick up whatever the exchange delivered or took last time step
+  storage_inventory.Sync();
+  excess_inventory.Sync();
+  if (record_sensitivities) {
+    sensitivity.Sync(storage_inventory.quantity(), excess_inventory.quantity(),
+                     sequestered_tritium.tritium(),
+                     sequestered_tritium.helium3());
+  }
 
-  if (ReadyToOperate()) {
-    fuel_startup_policy.Stop();
-    fuel_refill_policy.Start();
+  {
+    TRICYCLE_PERF_SCOPE(perf, "DecayInventories");
+    DecayInventories();
+  }
+  {
+    TRICYCLE_PERF_SCOPE(perf, "ExtractHelium");
+    ExtractHelium();
+  }
+  {
+    TRICYCLE_PERF_SCOPE(perf, "ReadyToOperate");
+    operating = ReadyToOperate();
+  }
+  if (operating) {
+    StartRefill();
 
-    LoadCore();
-    OperateReactor();
+    {
+      TRICYCLE_PERF_SCOPE(perf, "LoadCore");
+      LoadCore();
+    }
+    {
+      TRICYCLE_PERF_SCOPE(perf, "OperateReactor");
+      OperateReactor();
+    }
+    if (record_sensitivities) {
+      sensitivity.Operate();
+    }
 
   } else {
     // Some way of leaving a record of what is going wrong is helpful info I
     // think Use the cyclus logger
   }
   
-  double excess_tritium = std::max(tritium_storage.quantity() - 
-                                  (reserve_inventory + SequesteredTritiumGap())
-                                  , 0.0);
-  
+  {
+    TRICYCLE_PERF_SCOPE(perf, "MoveExcess");
+    MoveExcess();
+  }
+
+  if (sequestered_tritium.quantity() != 0) {
+    StartRefill();
+  }
+
+  // Held tritium decays, and the startup request follows it, so a plant
+  // holding any is never idle
+  quiescent = quiescent_mode && !record_sensitivities && !operating &&
+              sequestered_tritium.quantity() < cyclus::eps_rsrc() &&
+              storage_inventory.tritium() < cyclus::eps_rsrc() &&
+              excess_inventory.tritium() < cyclus::eps_rsrc();
+  idle_quantities = quiescent ? BufferQuantities() : std::vector<double>();
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+std::vector<double> FusionPowerPlant::BufferQuantities() {
+  return {tritium_storage.quantity(), tritium_excess.quantity(),
+          helium_excess.quantity(), blanket_feed.quantity(),
+          blanket_waste.quantity()};
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void FusionPowerPlant::MoveExcess() {
+  bool forecast = (refuel_mode == "forecast");
+  double excess_tritium =
+      forecast ? std::max(storage_inventory.quantity() - ForecastTarget(), 0.0)
+               : ExcessStorage(storage_inventory.quantity(), step_reserve,
+                               SequesteredTritiumGap());
+
   // Otherwise the ResBuf encounters an error when it tries to squash
   if (excess_tritium > cyclus::eps_rsrc()) {
-    tritium_excess.Push(tritium_storage.Pop(excess_tritium));
+    storage_inventory.Transfer(&excess_inventory, excess_tritium);
+  }
+  if (record_sensitivities) {
+    // The forecast target is not differentiated, so its move is taken as is
+    if (forecast) {
+      sensitivity.MoveExcess(excess_tritium);
+    } else {
+      sensitivity.MoveExcess();
+    }
   }
 
-  if (sequestered_tritium->quantity() != 0) {
-    fuel_startup_policy.Stop();
-    fuel_refill_policy.Start();
+  // Both buffers can trade this time step
+  storage_inventory.Materialize();
+  excess_inventory.Materialize();
+
+  if (forecast) {
+    // Nothing is bought until the storage would fall below the reserve by
+    // the next time step, then enough for the whole horizon
+    double storage = tritium_storage.quantity();
+    double lot = 0;
+    if (storage < ForecastReorderLevel()) {
+      lot = ForecastTarget() - storage;
+    }
+    forecast_tracker.set_capacity(storage + std::max(lot, 0.0));
   }
 }
 
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+double FusionPowerPlant::ForecastTarget() {
+  double surviving = TritiumSurvival(context()->dt());
+  double net = ForecastNet(fuel_usage_mass, TBR, sequestered_equilibrium,
+                           surviving);
+  int steps =
+      PeriodSteps(forecast_horizon * kDefaultTimeStepDur, context()->dt());
+  return ForecastStorage(step_reserve, net, surviving, steps) +
+         SequesteredTritiumGap();
+}
+
+double FusionPowerPlant::ForecastReorderLevel() {
+  double surviving = TritiumSurvival(context()->dt());
+  double net = ForecastNet(fuel_usage_mass, TBR, sequestered_equilibrium,
+                           surviving);
+  return ForecastStorage(step_reserve, net, surviving, 1) +
+         SequesteredTritiumGap();
+}
+
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 void FusionPowerPlant::Tock() {
-  // ExplicitInventories wasn't working. If possible, may be best to use that
-  // down the road.
-  RecordInventories(tritium_storage.quantity(), tritium_excess.quantity(),
-                    sequestered_tritium->quantity(), blanket_feed.quantity(),
-                    blanket_waste.quantity(), helium_excess.quantity());
+  {
+    TRICYCLE_PERF_SCOPE(perf, "Tock");
+    // ExplicitInventories wasn't working. If possible, may be best to use
+    // that down the road.
+    // Startups and stalls are always recorded
+    bool transition = (operating != recorded_operating);
+    recorded_operating = operating;
+
+    // Nothing changed on an idle tick, apart from the last one
+    cyclus::Context* ctx = context();
+    if (!idle_tick || ctx->time() >= ctx->sim_info().duration - 1) {
+      RecordInventories(tritium_storage.quantity(), tritium_excess.quantity(),
+                        sequestered_tritium.quantity(), blanket_feed.quantity(),
+                        blanket_waste.quantity(), helium_excess.quantity(),
+                        transition);
+    }
+    if (record_sensitivities) {
+      RecordSensitivities(transition);
+    }
+    dre.Record();
+    SaveState();
+  }
+  // After the Tock span, so that it is part of the aggregates
+  TRICYCLE_PERF_END_STEP(perf);
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void FusionPowerPlant::RecordSensitivities(bool transition) {
+  // Whatever the exchange moved since MoveExcess. A fill policy that got
+  // all it asked for leaves the storage at its fill level.
+  double delivered = tritium_storage.quantity() - sensitivity.storage().v;
+  if (sequestered_tritium.quantity() < cyclus::eps_rsrc()) {
+    sensitivity.Deliver(delivered, sensitivity.reserve_inventory() +
+                                       sensitivity.sequestered_equilibrium());
+  } else if (refuel_mode == "fill") {
+    sensitivity.Deliver(delivered, sensitivity.reserve_inventory());
+  } else {
+    sensitivity.Deliver(delivered);
+  }
+  sensitivity.Sell(sensitivity.excess().v - tritium_excess.quantity());
+
+  sensitivity_recorder.Record(sensitivity.Derivatives(), transition);
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void FusionPowerPlant::SaveState() {
+  storage_inventory.Sync();
+  excess_inventory.Sync();
+
+  blanket_mass = blanket.mass();
+  incore_fuel_mass = incore_fuel.mass();
+  sequestered_mass = sequestered_tritium.mass();
+  storage_mass = storage_inventory.ledger().mass();
+  excess_mass = excess_inventory.ledger().mass();
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void FusionPowerPlant::RestoreState() {
+  blanket = BlanketState();
+  blanket.Fill(blanket_mass);
+  incore_fuel = TritiumLedger();
+  incore_fuel.Absorb(incore_fuel_mass);
+  sequestered_tritium = TritiumLedger();
+  sequestered_tritium.Absorb(sequestered_mass);
+
+  // The buffered materials may carry an older composition than the ledgers
+  TritiumLedger ledger;
+  ledger.Absorb(storage_mass);
+  storage_inventory.Restore(ledger);
+  ledger = TritiumLedger();
+  ledger.Absorb(excess_mass);
+  excess_inventory.Restore(ledger);
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void FusionPowerPlant::Decommission() {
+  TRICYCLE_PERF_FLUSH(perf);
+  cyclus::Facility::Decommission();
 }
 
 void FusionPowerPlant::RecordInventories(double tritium_storage,
@@ -143,52 +462,35 @@ void FusionPowerPlant::RecordInventories(double tritium_storage,
                                          double sequestered_tritium,
                                          double blanket_feed,
                                          double blanket_waste,
-                                         double helium_excess) {
-  context()
-      ->NewDatum("FPPInventories")
-      ->AddVal("AgentId", id())
-      ->AddVal("Time", context()->time())
-      ->AddVal("TritiumStorage", tritium_storage)
-      ->AddVal("TritiumExcess", tritium_excess)
-      ->AddVal("TritiumSequestered", sequestered_tritium)
-      ->AddVal("BlanketFeed", blanket_feed)
-      ->AddVal("BlanketWaste", blanket_waste)
-      ->AddVal("HeliumExcess", helium_excess)
-      ->Record();
+                                         double helium_excess,
+                                         bool transition) {
+  recorder.Record({tritium_storage, tritium_excess, sequestered_tritium,
+                   blanket_feed, blanket_waste, helium_excess},
+                  transition);
 }
 
 double FusionPowerPlant::SequesteredTritiumGap() {
-  double current_sequestered_tritium = 0.0;
-
-  if (sequestered_tritium->quantity() > cyclus::eps_rsrc()) {
-    cyclus::toolkit::MatQuery mq(sequestered_tritium);
-    current_sequestered_tritium = mq.mass(tritium_id);
-  }
-  return std::max(sequestered_equilibrium - current_sequestered_tritium, 0.0);
+  return SequesteredGap(sequestered_equilibrium, sequestered_tritium.tritium());
 }
 
 bool FusionPowerPlant::TritiumStorageClean() {
-  cyclus::toolkit::MatQuery mq(tritium_storage.Peek());
-  return cyclus::AlmostEq(mq.mass(tritium_id), tritium_storage.quantity());
+  return storage_inventory.pure();
 }
 
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 bool FusionPowerPlant::ReadyToOperate() {
   // Determine tritium inventory required to operate
-  double required_storage_inventory = SequesteredTritiumGap();
-  if (sequestered_tritium->quantity() < cyclus::eps_rsrc()) {
-    required_storage_inventory += reserve_inventory;
-    required_storage_inventory *= tritium_startup_fraction;
-  } else {
-    required_storage_inventory += fuel_usage_mass;
-  }
+  double required_storage_inventory = RequiredStorage(
+      sequestered_tritium.quantity() >= cyclus::eps_rsrc(),
+      SequesteredTritiumGap(), step_reserve, tritium_startup_fraction,
+      fuel_usage_mass);
 
   // check  tritium storage quantity requirement
-  if (tritium_storage.quantity() < required_storage_inventory ||
+  if (storage_inventory.quantity() < required_storage_inventory ||
       !TritiumStorageClean()) {
     return false;
   }
-  if (BlanketCycleTime() && blanket_feed.quantity() < blanket_turnover) {
+  if (blanket_feed.quantity() < BlanketTurnoverDue()) {
     return false;
   }
   return true;
@@ -199,93 +501,89 @@ void FusionPowerPlant::LoadCore() {
 
   // Squash runs into issues when you give it zero, so we need to check frist
   if (SequesteredTritiumGap() > cyclus::eps_rsrc()) {
-    sequestered_tritium->Absorb(tritium_storage.Pop(SequesteredTritiumGap()));
+    sequestered_tritium.Add(storage_inventory.Remove(SequesteredTritiumGap()));
   }
 
   CycleBlanket();
-  incore_fuel->Absorb(tritium_storage.Pop(fuel_usage_mass));
+  incore_fuel.Add(storage_inventory.Remove(fuel_usage_mass));
 
 }
 
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 void FusionPowerPlant::BreedTritium(double T_burned) {
-  int Li6_id = pyne::nucname::id("Li-6");
-  int Li7_id = pyne::nucname::id("Li-7");
-  int He4_id = pyne::nucname::id("He-4");
+  // Breed tritium
+  double T_created = T_burned * TBR;
+  BreedingYield yield = Breeding(T_created, Li7_contribution);
 
-  double Li6_molar_mass = pyne::atomic_mass(Li6_id);
-  double Li7_molar_mass = pyne::atomic_mass(Li7_id);
-  double T_molar_mass = pyne::atomic_mass(tritium_id);
-  double He4_molar_mass = pyne::atomic_mass(He4_id);
+  blanket.Breed(yield.li6, yield.li7, yield.he4);
 
-  Composition::Ptr Li6 = Composition::CreateFromAtom(CompMap({{Li6_id, 1.0}}));
-  Composition::Ptr Li7 = Composition::CreateFromAtom(CompMap({{Li7_id, 1.0}}));
-  Composition::Ptr Tritium =
-      Composition::CreateFromAtom(CompMap({{tritium_id, 1.0}}));
-  Composition::Ptr He4 = Composition::CreateFromAtom(CompMap({{He4_id, 1.0}}));
+  storage_inventory.Push(
+      InternalMaterial(T_created, CompRegistry::Tritium()));
+}
 
-  // Breed tritium
-  Material::Ptr T_created = Material::Create(this, T_burned * TBR, Tritium);
-  double T_created_atoms = T_created->quantity() * T_molar_mass;
-  Material::Ptr Li7_burned = Material::CreateUntracked(
-      T_created_atoms * Li7_contribution / Li7_molar_mass, Li7);
-  Material::Ptr Li6_burned = Material::CreateUntracked(
-      T_created_atoms * (1 - Li7_contribution) / Li6_molar_mass, Li6);
-  Material::Ptr He4_generated =
-      Material::CreateUntracked(T_created_atoms / He4_molar_mass, He4);
-
-  Material::Ptr consumed_Li = blanket->ExtractComp(Li7_burned->quantity(), Li7);
-  consumed_Li->Absorb(blanket->ExtractComp(Li6_burned->quantity(), Li6));
-  blanket->Absorb(He4_generated);
-
-  tritium_storage.Push(T_created);
+Material::Ptr FusionPowerPlant::InternalMaterial(double qty,
+                                                 cyclus::Composition::Ptr comp) {
+  if (track_internal_flows) {
+    return Material::Create(this, qty, comp);
+  }
+  return Material::CreateUntracked(qty, comp);
 }
 
 void FusionPowerPlant::OperateReactor() {
-  Material::Ptr consumed_fuel = incore_fuel->ExtractQty(fuel_usage_mass);
+  incore_fuel.Extract(fuel_usage_mass);
   BreedTritium(fuel_usage_mass);
 }
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 void FusionPowerPlant::DecayInventories() {
-  tritium_storage.Decay();
-  tritium_excess.Decay();
-  sequestered_tritium->Decay(context()->time());
+  int dt = context()->time() - decay_time;
+  decay_time = context()->time();
+
+  if (context()->sim_info().decay == "never") {
+    return;
+  }
+
+  storage_inventory.Decay(dt, context()->dt());
+  excess_inventory.Decay(dt, context()->dt());
+  sequestered_tritium.Decay(dt, context()->dt());
+  if (record_sensitivities) {
+    sensitivity.Decay(TritiumSurvival(dt * context()->dt()));
+  }
 }
 
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 void FusionPowerPlant::ExtractHelium() {
-  int He3_id = pyne::nucname::id("He-3");
-  Composition::Ptr He3 = Composition::CreateFromAtom(CompMap({{He3_id, 1.0}}));
-
-  std::vector<ResBuf<Material>*> tritium_buffers = {&tritium_storage,
-                                                    &tritium_excess};
+  std::vector<TritiumBuffer*> tritium_buffers = {&storage_inventory,
+                                                 &excess_inventory};
 
   for (auto* inventory : tritium_buffers) {
-    if (!inventory->empty()) {
-      Material::Ptr mat = inventory->Pop();
-      cyclus::toolkit::MatQuery mq(mat);
-
-      Material::Ptr helium = mat->ExtractComp(mq.mass(He3_id), He3);
-
+    Material::Ptr helium = inventory->ExtractHelium3();
+    if (helium) {
       helium_excess.Push(helium);
-      inventory->Push(mat);
     }
   }
 }
 
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 void FusionPowerPlant::CycleBlanket() {
-  if (blanket->quantity() < cyclus::eps_rsrc()) {
-    blanket->Absorb(blanket_feed.Pop(blanket_size));
-  } else if (BlanketCycleTime()) {
-    blanket_waste.Push(blanket->ExtractQty(blanket_turnover));
-    blanket->Absorb(blanket_feed.Pop(blanket_turnover));
+  if (blanket.quantity() < cyclus::eps_rsrc()) {
+    blanket.Fill(blanket_feed.Pop(blanket_size));
+    return;
+  }
+
+  double turnover = BlanketTurnoverDue();
+  if (turnover > 0) {
+    // The blanket only becomes a material again once it leaves the core
+    blanket_waste.Push(blanket.Extract(turnover)
+                           .ToMaterial(track_internal_flows ? this : NULL));
+    blanket.Fill(blanket_feed.Pop(turnover));
   }
 }
 
-bool FusionPowerPlant::BlanketCycleTime() {
-  return ((context()->time() > 0) &&
-          (context()->time() % blanket_turnover_frequency == 0));
+double FusionPowerPlant::BlanketTurnoverDue() {
+  int cycles = BlanketCycles(context()->time(),
+                             blanket_turnover_frequency * kDefaultTimeStepDur,
+                             context()->dt());
+  return BlanketTurnover(cycles, blanket_turnover, blanket_size);
 }
 
 // WARNING! Do not change the following this function!!! This enables your
@@ -1,11 +1,22 @@
 #ifndef CYCLUS_TRICYCLE_FUSION_POWER_PLANT_H_
 #define CYCLUS_TRICYCLE_FUSION_POWER_PLANT_H_
 
+#include <map>
 #include <string>
 
 #include "cyclus.h"
 #include "boost/shared_ptr.hpp"
-#include "pyne.h"
+#include "blanket_state.h"
+#include "inventory_recorder.h"
+#include "nuclides.h"
+#include "observed_policies.h"
+#include "perf_timer.h"
+#include "plant_kernels.h"
+#include "plant_sensitivity.h"
+#include "tritium_buffer.h"
+#include "tritium_decay.h"
+
+#pragma cyclus exec from cyclus.system import CY_LARGE_DOUBLE
 
 using cyclus::Material;
 
@@ -66,6 +77,9 @@ class FusionPowerPlant : public cyclus::Facility  {
   /// @param time the time of the tock
   virtual void Tock();
 
+  /// Writes the phase timers (TRICYCLE_PERF builds only)
+  virtual void Decommission();
+
   /// A verbose printer for the FusionPowerPlant
   virtual std::string str();
 
@@ -143,10 +157,10 @@ class FusionPowerPlant : public cyclus::Facility  {
 
   #pragma cyclus var { \
     "default": 'fill', \
-    "doc": "Method of refueling the reactor", \
-    "tooltip": "Options: 'schedule' or 'fill'", \
+    "doc": "Method of refueling the reactor. 'fill' tops the storage up to reserve_inventory every time step, 'schedule' buys buy_quantity every buy_frequency months, and 'forecast' only buys when the storage is forecast to drop below reserve_inventory by the next time step, enough to last forecast_horizon months", \
+    "tooltip": "Options: 'schedule', 'fill' or 'forecast'", \
     "uitype": "combobox", \
-    "categorical": ['schedule', 'fill'], \
+    "categorical": ['schedule', 'fill', 'forecast'], \
     "uilabel": "Refuel Mode" \
   }
   std::string refuel_mode;
@@ -164,15 +178,26 @@ class FusionPowerPlant : public cyclus::Facility  {
 
   #pragma cyclus var { \
     "default": 1, \
-    "doc": "Frequency which reactor tries to purchase new fuel", \
-    "tooltip": "Reactor is active for 1 timestep, then dormant for buy_frequency-1 timesteps", \
-    "units": "Timesteps", \
+    "doc": "Months between fuel purchases in schedule mode, rounded to whole time steps. If a time step is longer, each purchase covers all the periods in it.", \
+    "tooltip": "Reactor buys once every buy_frequency months", \
+    "units": "months", \
     "uitype": "range", \
-    "range": [0, 1e299], \
+    "range": [1, 1e299], \
     "uilabel": "Buy frequency" \
   }
   int buy_frequency;
 
+  #pragma cyclus var { \
+    "default": 12, \
+    "doc": "Months each purchase must keep the tritium storage above reserve_inventory for in forecast mode, rounded to whole time steps", \
+    "tooltip": "Months covered by each purchase in forecast mode", \
+    "units": "months", \
+    "uitype": "range", \
+    "range": [1, 1e9], \
+    "uilabel": "Forecast horizon" \
+  }
+  int forecast_horizon;
+
   #pragma cyclus var { \
     "doc": "Helium-3 output commodity Designation", \
     "tooltip": "He-3 output commodity", \
@@ -225,18 +250,92 @@ class FusionPowerPlant : public cyclus::Facility  {
 
   #pragma cyclus var { \
     "default": 1, \
-    "doc": "number of timesteps between blanket recycles", \
-    "tooltip": "Defaults to 0.05 (5%), must be between 0 and 15%", \
-    "units": "dimensionless", \
+    "doc": "Months between blanket recycles. Time steps spanning several turnover periods recycle blanket_turnover_fraction of the blanket for each of them.", \
+    "tooltip": "Months between blanket recycles", \
+    "units": "months", \
     "uitype": "range", \
     "range": [0, 1000], \
     "uilabel": "Blanket Turnover Rate" \
   }
   int blanket_turnover_frequency;
 
+  #pragma cyclus var { \
+    "default": True, \
+    "doc": "If false, tritium and blanket material moved around inside the plant (breeding, core loading, sequestration, helium separation) is untracked, and a tracked resource is only created when material is traded away. The lots sold out of each buffer are split off one tracked parent, so sold material keeps a parent chain", \
+    "tooltip": "Record intra-plant material flows in the Resources table", \
+    "uilabel": "Track Internal Flows" \
+  }
+  bool track_internal_flows;
+
+  #pragma cyclus var { \
+    "default": 1, \
+    "doc": "Inventories are only recorded every record_stride time steps (state transitions and the last time step are always recorded)", \
+    "tooltip": "Time steps between inventory records", \
+    "units": "Timesteps", \
+    "uitype": "range", \
+    "range": [1, 1e9], \
+    "uilabel": "Inventory Record Stride" \
+  }
+  int record_stride;
+
+  #pragma cyclus var { \
+    "default": 0.0, \
+    "doc": "Relative change any inventory must exceed since the last record for a new record to be written. 0 records unconditionally.", \
+    "tooltip": "Relative deadband for inventory records", \
+    "units": "dimensionless", \
+    "uitype": "range", \
+    "range": [0, 1e299], \
+    "uilabel": "Inventory Record Tolerance" \
+  }
+  double record_tolerance;
+
+  #pragma cyclus var { \
+    "default": False, \
+    "doc": "If true, the requests, bids and trades of each of the plant's policies are counted and written to the DreTraffic table every time step", \
+    "tooltip": "Record exchange traffic per policy", \
+    "uilabel": "Record DRE Traffic" \
+  }
+  bool record_dre;
+
+  #pragma cyclus var { \
+    "default": False, \
+    "doc": "If true, policies only post requests and bids that could change the outcome of the exchange: the blanket is only refilled while it is short, byproducts are only offered while on hand, and the startup and refill fuel requests never overlap. Posts for less than prune_threshold are dropped.", \
+    "tooltip": "Suppress idle requests and bids", \
+    "uilabel": "Prune Exchange" \
+  }
+  bool prune_exchange;
+
+  #pragma cyclus var { \
+    "default": 0.0, \
+    "doc": "Smallest request or offer posted in prune_exchange mode", \
+    "tooltip": "Smallest quantity posted when pruning", \
+    "units": "kg", \
+    "uitype": "range", \
+    "range": [0, CY_LARGE_DOUBLE], \
+    "uilabel": "Prune Threshold" \
+  }
+  double prune_threshold;
+
+  #pragma cyclus var { \
+    "default": False, \
+    "doc": "If true, a plant waiting for its startup inventory skips its per time step work (decay, helium extraction, startup checks and inventory records) until a trade adds to or takes from one of its buffers. Only a plant holding no tritium is idle, so its inventories and trades are the same as with quiescent_mode off.", \
+    "tooltip": "Skip idle time steps while waiting for startup", \
+    "uilabel": "Quiescent Mode" \
+  }
+  bool quiescent_mode;
+
+  #pragma cyclus var { \
+    "default": False, \
+    "doc": "If true, derivatives of the tritium storage, excess and sequestered inventories and of the lithium burned with respect to TBR, reserve_inventory, Li7_contribution and the burn rate are propagated along the run and written to the FPPSensitivities table every time step. Turns quiescent_mode off.", \
+    "tooltip": "Record inventory sensitivities", \
+    "uilabel": "Record Sensitivities" \
+  }
+  bool record_sensitivities;
+
   //Functions:
   void CycleBlanket();
-  bool BlanketCycleTime();
+  /// Blanket mass to swap out this time step, 0 if no turnover is due
+  double BlanketTurnoverDue();
   bool ReadyToOperate();
   void LoadCore();
   void BreedTritium(double T_burned);
@@ -245,52 +344,222 @@ class FusionPowerPlant : public cyclus::Facility  {
   void ExtractHelium();
   double SequesteredTritiumGap();
   bool TritiumStorageClean();
-  void RecordInventories(double tritium_storage, double tritium_excess, 
-                         double sequestered_tritium, double blanket_feed, 
-                         double blanket_excess, double helium_excess);
+  /// Creates material that stays inside the plant, tracked or not depending
+  /// on track_internal_flows
+  Material::Ptr InternalMaterial(double qty, cyclus::Composition::Ptr comp);
+  void InitRecorder();
+  void PrunePolicies();
+  /// Hands fuel purchases over from the startup to the refill policy
+  void StartRefill();
+  /// Tritium storage to keep in forecast mode, and the level under which
+  /// more is bought
+  double ForecastTarget();
+  double ForecastReorderLevel();
+  /// Moves tritium beyond what the plant needs over to excess storage, and
+  /// in forecast mode sizes the next purchase
+  void MoveExcess();
+  /// Quantities of the traded buffers, to tell whether a trade happened
+  std::vector<double> BufferQuantities();
+  /// Applies the exchange's deliveries and sales to the sensitivities and
+  /// records them
+  void RecordSensitivities(bool transition);
+  void RecordInventories(double tritium_storage, double tritium_excess,
+                         double sequestered_tritium, double blanket_feed,
+                         double blanket_excess, double helium_excess,
+                         bool transition = false);
 
 
  private:
+  /// Copies the in-core inventories and tritium ledgers into their restart
+  /// state variables
+  void SaveState();
+  /// Rebuilds the in-core inventories and tritium ledgers from their restart
+  /// state variables, which are empty for a newly deployed plant
+  void RestoreState();
+
   //Resource Buffers and Trackers:
+  #pragma cyclus var {"tooltip": "Tritium fuel storage"}
   cyclus::toolkit::ResBuf<cyclus::Material> tritium_storage;
+
+  #pragma cyclus var {"tooltip": "Excess tritium awaiting sale"}
   cyclus::toolkit::ResBuf<cyclus::Material> tritium_excess;
+
+  #pragma cyclus var {"tooltip": "Extracted helium-3 awaiting sale"}
   cyclus::toolkit::ResBuf<cyclus::Material> helium_excess;
+
+  #pragma cyclus var {"tooltip": "Fresh blanket material"}
   cyclus::toolkit::ResBuf<cyclus::Material> blanket_feed;
+
+  #pragma cyclus var {"tooltip": "Spent blanket material awaiting sale"}
   cyclus::toolkit::ResBuf<cyclus::Material> blanket_waste;
 
-  cyclus::toolkit::MatlBuyPolicy fuel_startup_policy;
-  cyclus::toolkit::MatlBuyPolicy fuel_refill_policy;
-  cyclus::toolkit::MatlBuyPolicy blanket_fill_policy;
+  // Nuclide ledgers kept in step with the tritium buffers
+  TritiumBuffer storage_inventory;
+  TritiumBuffer excess_inventory;
+
+  ObservedBuyPolicy fuel_startup_policy;
+  ObservedBuyPolicy fuel_refill_policy;
+  ObservedBuyPolicy blanket_fill_policy;
+
+  ObservedSellPolicy tritium_sell_policy;
+  ObservedSellPolicy helium_sell_policy;
+  ObservedSellPolicy blanket_waste_sell_policy;
 
-  cyclus::toolkit::MatlSellPolicy tritium_sell_policy;
-  cyclus::toolkit::MatlSellPolicy helium_sell_policy;
-  cyclus::toolkit::MatlSellPolicy blanket_waste_sell_policy;
+  // Sold lots of the untracked excess buffers, one parent chain per buffer
+  TrackedLot tritium_lot;
+  TrackedLot helium_lot;
+  TrackedLot blanket_waste_lot;
 
   cyclus::toolkit::TotalInvTracker fuel_tracker;
   cyclus::toolkit::TotalInvTracker blanket_tracker;
+  // Limits the forecast mode refill policy to the next purchase
+  cyclus::toolkit::TotalInvTracker forecast_tracker;
 
   //This is to correctly instantiate the TotalInvTracker(s)
   double fuel_limit = 1000.0;
   double blanket_limit = 100000.0; 
-  Material::Ptr blanket;
+  BlanketState blanket;
+
+  #pragma cyclus var { \
+    "default": 0.0, \
+    "internal": True, \
+    "doc": "Blanket mass swapped out per turnover (internal state)", \
+    "units": "kg", \
+    "uilabel": "Blanket Turnover" \
+  }
   double blanket_turnover;
+
+  #pragma cyclus var { \
+    "default": 0.0, \
+    "internal": True, \
+    "doc": "Tritium burned per time step (internal state)", \
+    "units": "kg", \
+    "uilabel": "Fuel Usage Mass" \
+  }
   double fuel_usage_mass;
 
+  /// reserve_inventory, raised to one time step's burn where that is more
+  double step_reserve;
+
+
+  //Internal inventories, these never cross a trade boundary:
+  TritiumLedger sequestered_tritium;
+  TritiumLedger incore_fuel;
+
+  // The in-core inventories and the tritium ledgers are not materials, so
+  // they are saved as nuclide masses (kg) at the end of every time step
+  #pragma cyclus var { \
+    "default": {}, \
+    "internal": True, \
+    "doc": "Nuclide masses of the in-core blanket (internal state)", \
+    "uilabel": "Blanket Mass" \
+  }
+  std::map<int, double> blanket_mass;
+
+  #pragma cyclus var { \
+    "default": {}, \
+    "internal": True, \
+    "doc": "Nuclide masses of the in-core fuel (internal state)", \
+    "uilabel": "In-core Fuel Mass" \
+  }
+  std::map<int, double> incore_fuel_mass;
 
-  //NucIDs for Pyne
-  const int tritium_id = 10030000;
+  #pragma cyclus var { \
+    "default": {}, \
+    "internal": True, \
+    "doc": "Nuclide masses of the sequestered tritium (internal state)", \
+    "uilabel": "Sequestered Mass" \
+  }
+  std::map<int, double> sequestered_mass;
 
-  //Compositions:
-  const cyclus::CompMap T = {{tritium_id, 1}};
-  const cyclus::Composition::Ptr tritium_comp = cyclus::Composition::CreateFromAtom(T);
+  #pragma cyclus var { \
+    "default": {}, \
+    "internal": True, \
+    "doc": "Decayed nuclide masses of tritium_storage (internal state)", \
+    "uilabel": "Storage Mass" \
+  }
+  std::map<int, double> storage_mass;
 
-  //Materials:
-  cyclus::Material::Ptr sequestered_tritium = cyclus::Material::CreateUntracked(0.0, tritium_comp);
-  cyclus::Material::Ptr incore_fuel = cyclus::Material::CreateUntracked(0.0, tritium_comp);
+  #pragma cyclus var { \
+    "default": {}, \
+    "internal": True, \
+    "doc": "Decayed nuclide masses of tritium_excess (internal state)", \
+    "uilabel": "Excess Mass" \
+  }
+  std::map<int, double> excess_mass;
+
+  // Last time the tritium inventories were decayed
+  #pragma cyclus var { \
+    "default": 0, \
+    "internal": True, \
+    "doc": "Time the tritium inventories were last decayed (internal state)", \
+    "uilabel": "Decay Time" \
+  }
+  int decay_time;
+
+  // Whether the reactor ran this time step and when last recorded
+  bool operating = false;
+
+  #pragma cyclus var { \
+    "default": False, \
+    "internal": True, \
+    "doc": "Whether the plant was operating when last recorded (internal state)", \
+    "uilabel": "Recorded Operating" \
+  }
+  bool recorded_operating;
+
+  #pragma cyclus var { \
+    "default": False, \
+    "internal": True, \
+    "doc": "Whether the plant has ever operated, after which fuel is only bought through the refill policy (internal state)", \
+    "uilabel": "Started Up" \
+  }
+  bool started_up;
+
+  #pragma cyclus var { \
+    "default": -1, \
+    "internal": True, \
+    "doc": "Time step the refill policy took over, -1 before startup. Scheduled purchases are counted from it. (internal state)", \
+    "uilabel": "Refill Start" \
+  }
+  int refill_start;
+
+  #pragma cyclus var { \
+    "default": False, \
+    "internal": True, \
+    "doc": "Whether the plant is waiting for startup with nothing to do (internal state)", \
+    "uilabel": "Quiescent" \
+  }
+  bool quiescent;
+
+  #pragma cyclus var { \
+    "default": [], \
+    "internal": True, \
+    "doc": "Buffer quantities a quiescent plant waits on a change of (internal state)", \
+    "uilabel": "Idle Quantities" \
+  }
+  std::vector<double> idle_quantities;
+
+  // Whether this time step's Tick was skipped
+  bool idle_tick = false;
+
+  InventoryRecorder recorder;
+
+  // Derivatives of the inventories, when record_sensitivities is set
+  PlantSensitivity sensitivity;
+  InventoryRecorder sensitivity_recorder;
+
+  // Time spent in each phase of Tick and Tock (TRICYCLE_PERF builds only)
+  PerfLog perf;
+
+  // Exchange traffic of the policies, when record_dre is set
+  DreCounter dre;
 
   // Constants
   static const double burn_rate; // kg/GW-y
 
+  friend class FusionPowerPlantBench;
+
   // And away we go!
 };
 
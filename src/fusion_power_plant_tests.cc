@@ -1,12 +1,17 @@
 #include <gtest/gtest.h>
 
+#include <algorithm>
 #include <cmath>
+#include <set>
+#include <sstream>
 
 #include "agent_tests.h"
 #include "context.h"
 #include "facility_tests.h"
 #include "fusion_power_plant.h"
 #include "pyhooks.h"
+#include "sim_init.h"
+#include "sqlite_back.h"
 
 using cyclus::CompMap;
 using cyclus::Cond;
@@ -355,6 +360,28 @@ TEST_F(FusionPowerPlantTest, EnterNotifyInvalidFill) {
 
   EXPECT_THROW(int id = sim.Run(), cyclus::KeyError);
 }
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+TEST_F(FusionPowerPlantTest, EnterNotifyUnknownBlanketRecipe) {
+  // A blanket recipe that is not defined is rejected in EnterNotify.
+
+  std::string config =
+      " <fusion_power>300</fusion_power>"
+      " <reserve_inventory>6.0</reserve_inventory>"
+      " <sequestered_equilibrium>2.121</sequestered_equilibrium>"
+      " <blanket_incommod>Enriched_Lithium</blanket_incommod>"
+      " <blanket_outcommod>Depleted_Lithium</blanket_outcommod>"
+      " <blanket_inrecipe>enriched_lithum</blanket_inrecipe>"
+      " <blanket_size>1000</blanket_size>"
+      " <he3_outcommod>Helium_3</he3_outcommod>"
+      " <TBR>1.00</TBR> "
+      " <fuel_incommod>Tritium</fuel_incommod>";
+
+  int simdur = 2;
+  cyclus::MockSim sim = InitializeSim(config, simdur);
+
+  EXPECT_THROW(sim.Run(), cyclus::KeyError);
+}
+
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 TEST_F(FusionPowerPlantTest, EnterNotifySellPolicy) {
   // Test sell policy behavior of enter notify.
@@ -385,6 +412,401 @@ TEST_F(FusionPowerPlantTest, EnterNotifySellPolicy) {
   EXPECT_EQ(simdur, qr_rows);
 }
 
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+TEST_F(FusionPowerPlantTest, UntrackedInternalFlows) {
+  // Untracked internal flows must not change the inventories, only the
+  // number of resources written to the database.
+  std::string config = common_config +
+                       " <TBR>1.30</TBR> "
+                       " <fuel_incommod>Tritium</fuel_incommod>"
+                       " <fuel_outcommod>TritiumFromFPP</fuel_outcommod>";
+  std::string untracked_config =
+      config + " <track_internal_flows>False</track_internal_flows>";
+
+  int simdur = 10;
+  cyclus::MockSim tracked_sim = InitializeSim(config, simdur);
+  tracked_sim.AddSink("TritiumFromFPP").Finalize();
+  tracked_sim.Run();
+
+  cyclus::MockSim untracked_sim = InitializeSim(untracked_config, simdur);
+  untracked_sim.AddSink("TritiumFromFPP").Finalize();
+  untracked_sim.Run();
+
+  QueryResult tracked = TimeInventoryQuery(tracked_sim, "9");
+  QueryResult untracked = TimeInventoryQuery(untracked_sim, "9");
+  EXPECT_NEAR(tracked.GetVal<double>("TritiumStorage"),
+              untracked.GetVal<double>("TritiumStorage"), 1e-9);
+  EXPECT_NEAR(tracked.GetVal<double>("BlanketWaste"),
+              untracked.GetVal<double>("BlanketWaste"), 1e-9);
+
+  // Sold tritium still shows up as a recorded resource
+  std::vector<Cond> conds;
+  conds.push_back(Cond("Commodity", "==", std::string("TritiumFromFPP")));
+  QueryResult sold = untracked_sim.db().Query("Transactions", &conds);
+  ASSERT_LT(0, sold.rows.size());
+  std::vector<Cond> resource;
+  resource.push_back(Cond("ResourceId", "==", sold.GetVal<int>("ResourceId")));
+  QueryResult sold_res = untracked_sim.db().Query("Resources", &resource);
+  EXPECT_EQ(1, sold_res.rows.size());
+
+  // Sold lots are not new resources but share one recorded parent chain
+  std::set<int> roots;
+  for (size_t i = 0; i < sold.rows.size(); ++i) {
+    int id = sold.GetVal<int>("ResourceId", i);
+    int parent = id;
+    while (parent != 0) {
+      id = parent;
+      std::vector<Cond> state;
+      state.push_back(Cond("ResourceId", "==", id));
+      QueryResult qr = untracked_sim.db().Query("Resources", &state);
+      ASSERT_EQ(1, qr.rows.size());
+      parent = qr.GetVal<int>("Parent1");
+    }
+    EXPECT_NE(sold.GetVal<int>("ResourceId", i), id);
+    roots.insert(id);
+  }
+  EXPECT_EQ(1, roots.size());
+
+  EXPECT_LT(untracked_sim.db().Query("Resources", NULL).rows.size(),
+            tracked_sim.db().Query("Resources", NULL).rows.size());
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+TEST_F(FusionPowerPlantTest, RestartMatchesUninterruptedRun) {
+  // A plant restarted from a snapshot ends up where an uninterrupted run
+  // does. Purchases every third time step make the schedule's phase part of
+  // the state that has to survive the restart.
+  std::string config = common_config +
+                       " <TBR>1.08</TBR> "
+                       " <fuel_incommod>Tritium</fuel_incommod>"
+                       " <buy_quantity>0.3</buy_quantity>"
+                       " <buy_frequency>3</buy_frequency>"
+                       " <refuel_mode>schedule</refuel_mode>";
+
+  int simdur = 12;
+  int half = 5;
+  cyclus::MockSim whole = InitializeSim(config, simdur);
+  whole.Run();
+
+  // Every simulation ends with a snapshot. The first half is restarted from
+  // it with its recorded duration stretched to the full length.
+  cyclus::MockSim first = InitializeSim(config, half);
+  first.Run();
+  std::stringstream duration;
+  duration << "UPDATE Info SET Duration = " << simdur;
+  first.db().db().Execute(duration.str());
+
+  cyclus::SimInit si;
+  si.Restart(&first.db(), first.context()->sim_id(), half);
+  cyclus::SqliteBack rest(":memory:");
+  si.recorder()->RegisterBackend(&rest);
+  si.timer()->RunSim();
+  si.recorder()->Flush();
+
+  std::vector<Cond> conds;
+  conds.push_back(Cond("Time", "==", simdur - 1));
+  QueryResult restarted = rest.Query("FPPInventories", &conds);
+  QueryResult uninterrupted =
+      TimeInventoryQuery(whole, std::to_string(simdur - 1));
+  ASSERT_EQ(1, restarted.rows.size());
+  const char* columns[] = {"TritiumStorage", "TritiumExcess",
+                           "TritiumSequestered", "BlanketFeed",
+                           "BlanketWaste", "HeliumExcess"};
+  for (const char* column : columns) {
+    EXPECT_NEAR(uninterrupted.GetVal<double>(column),
+                restarted.GetVal<double>(column), 1e-9)
+        << column;
+  }
+
+  // Fuel is still bought on the original schedule
+  std::vector<Cond> bought;
+  bought.push_back(Cond("Commodity", "==", std::string("Tritium")));
+  bought.push_back(Cond("Time", ">=", half));
+  EXPECT_EQ(whole.db().Query("Transactions", &bought).rows.size(),
+            rest.Query("Transactions", &bought).rows.size());
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+TEST_F(FusionPowerPlantTest, DecimatedRecording) {
+  // With a record stride only every few time steps (plus startup and the
+  // last time step) show up in FPPInventories.
+  std::string config = common_config +
+                       " <TBR>1.08</TBR> "
+                       " <fuel_incommod>Tritium</fuel_incommod>"
+                       " <record_stride>4</record_stride>";
+
+  int simdur = 10;
+  cyclus::MockSim sim = InitializeSim(config, simdur);
+  sim.Run();
+
+  QueryResult qr = sim.db().Query("FPPInventories", NULL);
+  std::vector<int> times;
+  for (size_t i = 0; i < qr.rows.size(); ++i) {
+    times.push_back(qr.GetVal<int>("Time", i));
+  }
+  std::sort(times.begin(), times.end());
+
+  std::vector<int> expected = {0, 4, 8, 9};
+  EXPECT_EQ(expected, times);
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+TEST_F(FusionPowerPlantTest, ForecastRefuel) {
+  // A plant breeding less than it burns buys fuel in lots lasting the
+  // forecast horizon instead of every time step, and never dips below its
+  // reserve doing so.
+  std::string config = common_config +
+                       " <TBR>0.9</TBR> "
+                       " <fuel_incommod>Tritium</fuel_incommod>";
+  std::string forecast = " <refuel_mode>forecast</refuel_mode>"
+                         " <forecast_horizon>6</forecast_horizon>";
+
+  int simdur = 13;
+  cyclus::MockSim fill_sim = InitializeSim(config, simdur);
+  fill_sim.Run();
+  cyclus::MockSim forecast_sim = InitializeSim(config + forecast, simdur);
+  forecast_sim.Run();
+
+  std::vector<Cond> conds;
+  conds.push_back(Cond("Commodity", "==", std::string("Tritium")));
+  int fill_trades = fill_sim.db().Query("Transactions", &conds).rows.size();
+  int forecast_trades =
+      forecast_sim.db().Query("Transactions", &conds).rows.size();
+  EXPECT_LE(simdur - 1, fill_trades);
+  EXPECT_GE(4, forecast_trades);
+
+  QueryResult qr = forecast_sim.db().Query("FPPInventories", NULL);
+  for (size_t i = 0; i < qr.rows.size(); ++i) {
+    EXPECT_LE(6.0 - 1e-6, qr.GetVal<double>("TritiumStorage", i))
+        << "at time " << qr.GetVal<int>("Time", i);
+  }
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+TEST_F(FusionPowerPlantTest, QuiescentWaiting) {
+  // A plant that never gets its startup inventory stops recording once its
+  // blanket is full, apart from the last time step, and ends up in the same
+  // state as a plant that did all the work.
+  std::string config = common_config +
+                       " <TBR>1.08</TBR> "
+                       " <fuel_incommod>NoTritium</fuel_incommod>";
+  std::string quiescent = " <quiescent_mode>1</quiescent_mode>";
+
+  int simdur = 10;
+  cyclus::MockSim full_sim = InitializeSim(config, simdur);
+  full_sim.Run();
+  cyclus::MockSim quiescent_sim = InitializeSim(config + quiescent, simdur);
+  quiescent_sim.Run();
+
+  QueryResult full = full_sim.db().Query("FPPInventories", NULL);
+  QueryResult qr = quiescent_sim.db().Query("FPPInventories", NULL);
+  EXPECT_EQ(simdur, full.rows.size());
+  EXPECT_GT(simdur, qr.rows.size());
+
+  QueryResult full_last = TimeInventoryQuery(full_sim, "9");
+  QueryResult last = TimeInventoryQuery(quiescent_sim, "9");
+  ASSERT_EQ(1, last.rows.size());
+  EXPECT_NEAR(full_last.GetVal<double>("BlanketFeed"),
+              last.GetVal<double>("BlanketFeed"), 1e-9);
+  EXPECT_DOUBLE_EQ(0.0, last.GetVal<double>("TritiumStorage"));
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+TEST_F(FusionPowerPlantTest, QuiescentMatchesFullRun) {
+  // A plant that idles until its tritium supplier comes online, then fills up
+  // over a few time steps and starts, trades and records the same values as a
+  // plant that did all the work
+  std::string config = common_config +
+                       " <TBR>1.08</TBR> "
+                       " <fuel_incommod>Tritium</fuel_incommod>";
+  std::string quiescent = " <quiescent_mode>1</quiescent_mode>";
+
+  int simdur = 20;
+  std::vector<cyclus::MockSim*> sims;
+  cyclus::MockSim full_sim(cyclus::AgentSpec(":tricycle:FusionPowerPlant"),
+                           config, simdur);
+  cyclus::MockSim quiescent_sim(
+      cyclus::AgentSpec(":tricycle:FusionPowerPlant"), config + quiescent,
+      simdur);
+  sims.push_back(&full_sim);
+  sims.push_back(&quiescent_sim);
+  for (size_t i = 0; i < sims.size(); ++i) {
+    sims[i]->AddRecipe("tritium", tritium());
+    sims[i]->AddRecipe("enriched_lithium", enriched_lithium());
+    sims[i]->AddSource("Enriched_Lithium").recipe("enriched_lithium").Finalize();
+    sims[i]->AddSource("Tritium")
+        .recipe("tritium")
+        .capacity(3)
+        .start(5)
+        .Finalize();
+    sims[i]->Run();
+  }
+
+  QueryResult full = full_sim.db().Query("FPPInventories", NULL);
+  QueryResult qr = quiescent_sim.db().Query("FPPInventories", NULL);
+  EXPECT_EQ(simdur, full.rows.size());
+  EXPECT_GT(simdur, qr.rows.size());
+
+  // Every row the quiescent plant wrote matches the full run at that time
+  std::vector<std::string> columns = {"TritiumStorage",    "TritiumExcess",
+                                      "TritiumSequestered", "HeliumExcess",
+                                      "BlanketFeed",       "BlanketWaste"};
+  for (size_t i = 0; i < qr.rows.size(); ++i) {
+    int time = qr.GetVal<int>("Time", i);
+    QueryResult full_row = TimeInventoryQuery(full_sim, std::to_string(time));
+    ASSERT_EQ(1, full_row.rows.size());
+    for (size_t j = 0; j < columns.size(); ++j) {
+      EXPECT_NEAR(full_row.GetVal<double>(columns[j]),
+                  qr.GetVal<double>(columns[j], i), 1e-9)
+          << columns[j] << " at time " << time;
+    }
+  }
+
+  QueryResult full_trades = full_sim.db().Query("Transactions", NULL);
+  QueryResult trades = quiescent_sim.db().Query("Transactions", NULL);
+  ASSERT_EQ(full_trades.rows.size(), trades.rows.size());
+  for (size_t i = 0; i < trades.rows.size(); ++i) {
+    EXPECT_EQ(full_trades.GetVal<int>("Time", i), trades.GetVal<int>("Time", i));
+    EXPECT_EQ(full_trades.GetVal<std::string>("Commodity", i),
+              trades.GetVal<std::string>("Commodity", i));
+  }
+
+  // Traded quantities come from the resources the transactions moved
+  double full_total = 0;
+  double total = 0;
+  for (size_t i = 0; i < full_trades.rows.size(); ++i) {
+    std::vector<Cond> conds;
+    conds.push_back(
+        Cond("ResourceId", "==", full_trades.GetVal<int>("ResourceId", i)));
+    full_total +=
+        full_sim.db().Query("Resources", &conds).GetVal<double>("Quantity");
+    conds.clear();
+    conds.push_back(
+        Cond("ResourceId", "==", trades.GetVal<int>("ResourceId", i)));
+    total +=
+        quiescent_sim.db().Query("Resources", &conds).GetVal<double>("Quantity");
+  }
+  EXPECT_NEAR(full_total, total, 1e-9);
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+TEST_F(FusionPowerPlantTest, RecordSensitivities) {
+  // Derivatives come out of the same run, one row per time step
+  std::string config = common_config +
+                       " <TBR>1.08</TBR> "
+                       " <fuel_incommod>Tritium</fuel_incommod>"
+                       " <record_sensitivities>true</record_sensitivities>";
+
+  int simdur = 10;
+  cyclus::MockSim sim = InitializeSim(config, simdur);
+  sim.Run();
+
+  QueryResult all = sim.db().Query("FPPSensitivities", NULL);
+  EXPECT_EQ(simdur, all.rows.size());
+
+  std::vector<Cond> conds;
+  conds.push_back(Cond("Time", "==", std::string("9")));
+  QueryResult qr = sim.db().Query("FPPSensitivities", &conds);
+
+  // The fill policy keeps the storage at the reserve, and the surplus of a
+  // TBR above one goes to excess
+  EXPECT_NEAR(1.0, qr.GetVal<double>("dTritiumStorage_dReserveInventory"),
+              1e-9);
+  EXPECT_NEAR(0.0, qr.GetVal<double>("dTritiumStorage_dTBR"), 1e-9);
+  EXPECT_LT(0, qr.GetVal<double>("dTritiumExcess_dTBR"));
+  EXPECT_LT(0, qr.GetVal<double>("dTritiumExcess_dBurnRate"));
+  EXPECT_NEAR(0.0, qr.GetVal<double>("dTritiumSequestered_dTBR"), 1e-12);
+  EXPECT_NE(0, qr.GetVal<double>("dLithiumBurned_dLi7Contribution"));
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+TEST(PlantKernelsTest, BlanketCyclesAnyTimeStep) {
+  double month = kDefaultTimeStepDur;
+
+  // Monthly steps, turnover every 3 months
+  std::vector<int> cycles;
+  for (int t = 0; t < 7; ++t) {
+    cycles.push_back(tricycle::BlanketCycles(t, 3 * month, month));
+  }
+  std::vector<int> expected = {0, 0, 0, 1, 0, 0, 1};
+  EXPECT_EQ(expected, cycles);
+
+  // Yearly steps catch up every monthly turnover of the year, and a year's
+  // turnovers of 5% each swap out 60% of the blanket
+  EXPECT_EQ(12, tricycle::BlanketCycles(1, month, 12 * month));
+  EXPECT_DOUBLE_EQ(600, tricycle::BlanketTurnover(12, 50, 1000));
+  EXPECT_DOUBLE_EQ(1000, tricycle::BlanketTurnover(30, 50, 1000));
+
+  // Quarterly steps with a yearly turnover only cycle every fourth step
+  EXPECT_EQ(0, tricycle::BlanketCycles(3, 12 * month, 3 * month));
+  EXPECT_EQ(1, tricycle::BlanketCycles(4, 12 * month, 3 * month));
+
+  // Schedules are rounded to whole time steps, at least one
+  EXPECT_EQ(4, tricycle::PeriodSteps(12 * month, 3 * month));
+  EXPECT_EQ(1, tricycle::PeriodSteps(month, 12 * month));
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+TEST(PlantKernelsTest, ScheduledQuantityAnyTimeStep) {
+  // 1 kg every 2 months buys 6 kg a year whatever the time step
+  double month = kDefaultTimeStepDur;
+  double period = 2 * month;
+  for (double dt : {month, 3 * month, 12 * month}) {
+    int steps = tricycle::PeriodSteps(period, dt);
+    double per_year = tricycle::ScheduledQuantity(1.0, period, steps, dt) *
+                      (12 * month / dt) / steps;
+    EXPECT_NEAR(6.0, per_year, 1e-12) << dt / month << " month steps";
+  }
+
+  // A period of 2 months rounds to one quarterly step, buying 1.5 kg
+  int quarterly = tricycle::PeriodSteps(period, 3 * month);
+  EXPECT_EQ(1, quarterly);
+  EXPECT_DOUBLE_EQ(
+      1.5, tricycle::ScheduledQuantity(1.0, period, quarterly, 3 * month));
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+TEST(PlantKernelsTest, StepReserveCoversOneStep) {
+  // A 6 kg reserve covers a month's burn but not a year's. On yearly steps
+  // the plant keeps a year's burn on hand, so that topping up to the
+  // reserve always leaves enough to run the next step.
+  double reserve = 6.0;
+  double monthly_burn = 1.4;
+  double yearly_burn = 12 * monthly_burn;
+  EXPECT_DOUBLE_EQ(reserve, tricycle::StepReserve(reserve, monthly_burn));
+  EXPECT_DOUBLE_EQ(yearly_burn, tricycle::StepReserve(reserve, yearly_burn));
+
+  double gap = 0.5;
+  double kept = tricycle::StepReserve(reserve, yearly_burn) + gap;
+  EXPECT_LE(tricycle::RequiredStorage(true, gap, reserve, 1.0, yearly_burn),
+            kept);
+  EXPECT_DOUBLE_EQ(0, tricycle::ExcessStorage(kept, kept - gap, gap));
+}
+
+#ifdef TRICYCLE_PERF
+TEST_F(FusionPowerPlantTest, PhaseTimers) {
+  // Every Tick and Tock is timed, and the aggregates are written once at
+  // the end of the simulation
+  std::string config = common_config +
+                       " <TBR>1.08</TBR> "
+                       " <fuel_incommod>Tritium</fuel_incommod>";
+
+  int simdur = 5;
+  cyclus::MockSim sim = InitializeSim(config, simdur);
+  sim.Run();
+
+  std::vector<Cond> conds;
+  conds.push_back(Cond("Phase", "==", std::string("Tick")));
+  QueryResult qr = sim.db().Query("TricyclePerf", &conds);
+  ASSERT_EQ(1, qr.rows.size());
+  EXPECT_EQ(simdur, qr.GetVal<int>("Calls"));
+  EXPECT_LE(qr.GetVal<double>("Min"), qr.GetVal<double>("Max"));
+
+  conds[0] = Cond("Phase", "==", std::string("DecayInventories"));
+  EXPECT_EQ(1, sim.db().Query("TricyclePerf", &conds).rows.size());
+}
+#endif  // TRICYCLE_PERF
+
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 // Do Not Touch! Below section required for connection with Cyclus
 cyclus::Agent* FusionPowerPlantConstructor(cyclus::Context* ctx) {
@@ -0,0 +1,79 @@
+// inventory_recorder.cc
+
+#include "inventory_recorder.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace tricycle {
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+InventoryRecorder::InventoryRecorder()
+    : agent_(NULL), stride_(1), tolerance_(0) {}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void InventoryRecorder::Init(cyclus::Agent* agent, std::string table,
+                             std::vector<std::string> columns, int stride,
+                             double tolerance) {
+  agent_ = agent;
+  table_ = table;
+  columns_ = columns;
+  stride_ = std::max(stride, 1);
+  tolerance_ = std::max(tolerance, 0.0);
+  last_.clear();
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+bool InventoryRecorder::Due(int time, const std::vector<double>& values,
+                            bool transition) const {
+  if (transition || last_.empty()) {
+    return true;
+  }
+  if (time % stride_ != 0) {
+    return false;
+  }
+  if (tolerance_ <= 0) {
+    return true;
+  }
+
+  for (size_t i = 0; i < values.size(); ++i) {
+    double change = std::abs(values[i] - last_[i]);
+    if (change > tolerance_ * std::abs(last_[i]) &&
+        change > cyclus::eps_rsrc()) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+bool InventoryRecorder::Sample(int time, const std::vector<double>& values,
+                               bool transition) {
+  if (!Due(time, values, transition)) {
+    return false;
+  }
+  last_ = values;
+  return true;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void InventoryRecorder::Record(const std::vector<double>& values,
+                               bool transition) {
+  cyclus::Context* ctx = agent_->context();
+  int time = ctx->time();
+  bool last_step = time >= ctx->sim_info().duration - 1;
+
+  if (!Sample(time, values, transition || last_step)) {
+    return;
+  }
+
+  cyclus::Datum* d = ctx->NewDatum(table_)
+                         ->AddVal("AgentId", agent_->id())
+                         ->AddVal("Time", time);
+  for (size_t j = 0; j < columns_.size(); ++j) {
+    d->AddVal(columns_[j], values[j]);
+  }
+  d->Record();
+}
+
+}  // namespace tricycle
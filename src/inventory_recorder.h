@@ -0,0 +1,56 @@
+#ifndef CYCLUS_TRICYCLE_INVENTORY_RECORDER_H_
+#define CYCLUS_TRICYCLE_INVENTORY_RECORDER_H_
+
+#include <string>
+#include <vector>
+
+#include "cyclus.h"
+
+namespace tricycle {
+
+/// @class InventoryRecorder
+/// Writes an agent's per-time-step inventory datums to a table, with an
+/// optional recording policy to keep large simulations from being dominated
+/// by inventory rows:
+///  - stride: only every stride-th time step is considered for recording
+///  - tolerance: a considered step is only written if some inventory changed
+///    by more than this fraction of its last written value
+///
+/// State transitions (e.g. a plant starting up or stalling) and the last time
+/// step of the simulation are always written. With the defaults (1, 0) every
+/// call writes one datum. Datums go straight to the context, whose recorder
+/// already buffers them.
+class InventoryRecorder {
+ public:
+  InventoryRecorder();
+
+  /// Sets the table, its inventory columns (in the order values will be
+  /// passed to Record) and the recording policy
+  void Init(cyclus::Agent* agent, std::string table,
+            std::vector<std::string> columns, int stride = 1,
+            double tolerance = 0);
+
+  /// Records the inventories of the current time step if the policy calls
+  /// for it. transition forces the datum to be written.
+  void Record(const std::vector<double>& values, bool transition = false);
+
+  /// Whether values are to be written for time under the policy. Values that
+  /// are become the reference for the tolerance.
+  bool Sample(int time, const std::vector<double>& values, bool transition);
+
+ private:
+  cyclus::Agent* agent_;
+  std::string table_;
+  std::vector<std::string> columns_;
+  int stride_;
+  double tolerance_;
+
+  /// Last values written, empty before the first datum
+  std::vector<double> last_;
+
+  bool Due(int time, const std::vector<double>& values, bool transition) const;
+};
+
+}  // namespace tricycle
+
+#endif  // CYCLUS_TRICYCLE_INVENTORY_RECORDER_H_
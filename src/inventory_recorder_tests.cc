@@ -0,0 +1,52 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "inventory_recorder.h"
+
+namespace tricycle {
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+TEST(InventoryRecorderTest, DefaultPolicyKeepsEverything) {
+  InventoryRecorder recorder;
+  recorder.Init(NULL, "Inventories", {"A"});
+
+  for (int t = 0; t < 5; ++t) {
+    EXPECT_TRUE(recorder.Sample(t, {1.0}, false));
+  }
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+TEST(InventoryRecorderTest, StrideAndTransitions) {
+  InventoryRecorder recorder;
+  recorder.Init(NULL, "Inventories", {"A"}, 4);
+
+  // The first sample is always kept
+  EXPECT_TRUE(recorder.Sample(1, {1.0}, false));
+  EXPECT_FALSE(recorder.Sample(2, {2.0}, false));
+  EXPECT_FALSE(recorder.Sample(3, {3.0}, false));
+  EXPECT_TRUE(recorder.Sample(4, {4.0}, false));
+  EXPECT_FALSE(recorder.Sample(5, {5.0}, false));
+
+  // Transitions are kept off-stride
+  EXPECT_TRUE(recorder.Sample(6, {6.0}, true));
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+TEST(InventoryRecorderTest, RelativeDeadband) {
+  InventoryRecorder recorder;
+  recorder.Init(NULL, "Inventories", {"A", "B"}, 1, 0.1);
+
+  EXPECT_TRUE(recorder.Sample(0, {10.0, 1.0}, false));
+  // Under 10% on both columns
+  EXPECT_FALSE(recorder.Sample(1, {10.5, 1.05}, false));
+  EXPECT_FALSE(recorder.Sample(2, {10.9, 1.0}, false));
+  // Compared to the last kept values, not the last sampled ones
+  EXPECT_TRUE(recorder.Sample(3, {10.0, 1.2}, false));
+  EXPECT_FALSE(recorder.Sample(4, {10.0, 1.25}, false));
+  // Leaving zero always counts as a change
+  EXPECT_TRUE(recorder.Sample(5, {0.0, 1.2}, false));
+  EXPECT_TRUE(recorder.Sample(6, {0.5, 1.2}, false));
+}
+
+}  // namespace tricycle
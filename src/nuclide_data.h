@@ -0,0 +1,31 @@
+#ifndef CYCLUS_TRICYCLE_NUCLIDE_DATA_H_
+#define CYCLUS_TRICYCLE_NUCLIDE_DATA_H_
+
+// Plain nuclear data used by the tricycle archetypes. This header does not
+// depend on cyclus so that it can be shared with the standalone plant
+// kernels.
+
+namespace tricycle {
+
+// NucIDs of every nuclide the tricycle archetypes handle directly
+constexpr int kTritiumId = 10030000;
+constexpr int kHelium3Id = 20030000;
+constexpr int kHelium4Id = 20040000;
+constexpr int kLithium6Id = 30060000;
+constexpr int kLithium7Id = 30070000;
+
+// Atomic masses (g/mol), matching the values pyne::atomic_mass returns from
+// nuc_data, so that no nuclear data has to be loaded to use them
+constexpr double kTritiumMass = 3.01604928199;
+constexpr double kHelium3Mass = 3.01602932265;
+constexpr double kHelium4Mass = 4.00260325415;
+constexpr double kLithium6Mass = 6.0151228874;
+constexpr double kLithium7Mass = 7.0160034366;
+
+// Half-life of tritium consistent with the pyne decay data used by
+// cyclus::Composition::Decay (s)
+constexpr double kTritiumHalfLife = 388789632.0;
+
+}  // namespace tricycle
+
+#endif  // CYCLUS_TRICYCLE_NUCLIDE_DATA_H_
@@ -0,0 +1,44 @@
+// nuclides.cc
+
+#include "nuclides.h"
+
+using cyclus::CompMap;
+using cyclus::Composition;
+
+namespace tricycle {
+
+namespace {
+
+Composition::Ptr SingleNuclide(int nuc) {
+  return Composition::CreateFromAtom(CompMap({{nuc, 1.0}}));
+}
+
+}  // namespace
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+Composition::Ptr CompRegistry::Tritium() {
+  static Composition::Ptr comp = SingleNuclide(kTritiumId);
+  return comp;
+}
+
+Composition::Ptr CompRegistry::Helium3() {
+  static Composition::Ptr comp = SingleNuclide(kHelium3Id);
+  return comp;
+}
+
+Composition::Ptr CompRegistry::Helium4() {
+  static Composition::Ptr comp = SingleNuclide(kHelium4Id);
+  return comp;
+}
+
+Composition::Ptr CompRegistry::Lithium6() {
+  static Composition::Ptr comp = SingleNuclide(kLithium6Id);
+  return comp;
+}
+
+Composition::Ptr CompRegistry::Lithium7() {
+  static Composition::Ptr comp = SingleNuclide(kLithium7Id);
+  return comp;
+}
+
+}  // namespace tricycle
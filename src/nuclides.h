@@ -0,0 +1,25 @@
+#ifndef CYCLUS_TRICYCLE_NUCLIDES_H_
+#define CYCLUS_TRICYCLE_NUCLIDES_H_
+
+#include "cyclus.h"
+#include "nuclide_data.h"
+
+namespace tricycle {
+
+/// @class CompRegistry
+/// Process-wide registry of interned single-nuclide compositions. Every
+/// agent gets the same Composition::Ptr for a given nuclide, which lets
+/// cyclus share compositions (and their decay caches) across agents and
+/// lets the archetypes compare compositions by pointer.
+class CompRegistry {
+ public:
+  static cyclus::Composition::Ptr Tritium();
+  static cyclus::Composition::Ptr Helium3();
+  static cyclus::Composition::Ptr Helium4();
+  static cyclus::Composition::Ptr Lithium6();
+  static cyclus::Composition::Ptr Lithium7();
+};
+
+}  // namespace tricycle
+
+#endif  // CYCLUS_TRICYCLE_NUCLIDES_H_
@@ -0,0 +1,32 @@
+#include <gtest/gtest.h>
+
+#include "cyclus.h"
+#include "nuclides.h"
+#include "pyne.h"
+
+namespace tricycle {
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+TEST(NuclidesTest, ConstantsMatchPyne) {
+  // The compile-time constants must agree with pyne's nuclear data
+  EXPECT_EQ(pyne::nucname::id("H-3"), kTritiumId);
+  EXPECT_EQ(pyne::nucname::id("He-3"), kHelium3Id);
+  EXPECT_EQ(pyne::nucname::id("He-4"), kHelium4Id);
+  EXPECT_EQ(pyne::nucname::id("Li-6"), kLithium6Id);
+  EXPECT_EQ(pyne::nucname::id("Li-7"), kLithium7Id);
+
+  EXPECT_NEAR(pyne::atomic_mass(kTritiumId), kTritiumMass, 1e-6);
+  EXPECT_NEAR(pyne::atomic_mass(kHelium3Id), kHelium3Mass, 1e-6);
+  EXPECT_NEAR(pyne::atomic_mass(kHelium4Id), kHelium4Mass, 1e-6);
+  EXPECT_NEAR(pyne::atomic_mass(kLithium6Id), kLithium6Mass, 1e-6);
+  EXPECT_NEAR(pyne::atomic_mass(kLithium7Id), kLithium7Mass, 1e-6);
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+TEST(NuclidesTest, RegistryInternsCompositions) {
+  EXPECT_EQ(CompRegistry::Tritium(), CompRegistry::Tritium());
+  EXPECT_NE(CompRegistry::Tritium(), CompRegistry::Helium3());
+  EXPECT_DOUBLE_EQ(1.0, CompRegistry::Lithium6()->atom().at(kLithium6Id));
+}
+
+}  // namespace tricycle
@@ -0,0 +1,195 @@
+// observed_policies.cc
+
+#include "observed_policies.h"
+
+#include <algorithm>
+
+namespace tricycle {
+
+namespace {
+
+/// Largest quantity asked for by any request of port
+double MaxRequested(const cyclus::RequestPortfolio<cyclus::Material>::Ptr& port) {
+  double qty = 0;
+  const std::vector<cyclus::Request<cyclus::Material>*>& requests =
+      port->requests();
+  for (size_t i = 0; i < requests.size(); ++i) {
+    qty = std::max(qty, requests[i]->target()->quantity());
+  }
+  return qty;
+}
+
+/// Number of requests in ports
+int NumRequests(
+    const std::set<cyclus::RequestPortfolio<cyclus::Material>::Ptr>& ports) {
+  int n = 0;
+  std::set<cyclus::RequestPortfolio<cyclus::Material>::Ptr>::const_iterator it;
+  for (it = ports.begin(); it != ports.end(); ++it) {
+    n += (*it)->requests().size();
+  }
+  return n;
+}
+
+/// Largest quantity offered by any bid of port
+double MaxOffered(const cyclus::BidPortfolio<cyclus::Material>::Ptr& port) {
+  double qty = 0;
+  const std::set<cyclus::Bid<cyclus::Material>*>& bids = port->bids();
+  std::set<cyclus::Bid<cyclus::Material>*>::const_iterator it;
+  for (it = bids.begin(); it != bids.end(); ++it) {
+    qty = std::max(qty, (*it)->offer()->quantity());
+  }
+  return qty;
+}
+
+/// Drops the portfolios of ports whose size is at most threshold
+template <class Port>
+void DropSmall(std::set<Port>& ports, double threshold,
+               double (*size)(const Port&)) {
+  threshold = std::max(threshold, cyclus::eps_rsrc());
+  typename std::set<Port>::iterator it = ports.begin();
+  while (it != ports.end()) {
+    if (size(*it) <= threshold) {
+      ports.erase(it++);
+    } else {
+      ++it;
+    }
+  }
+}
+
+/// Copy of port without the bids offering less than min_qty, or port itself
+/// if there are none
+cyclus::BidPortfolio<cyclus::Material>::Ptr DropSmallBids(
+    const cyclus::BidPortfolio<cyclus::Material>::Ptr& port, double min_qty) {
+  typedef cyclus::Bid<cyclus::Material> Bid;
+  const std::set<Bid*>& bids = port->bids();
+  std::set<Bid*>::const_iterator it;
+  bool small = false;
+  for (it = bids.begin(); it != bids.end() && !small; ++it) {
+    small = (*it)->offer()->quantity() < min_qty;
+  }
+  if (!small) {
+    return port;
+  }
+
+  cyclus::BidPortfolio<cyclus::Material>::Ptr kept(
+      new cyclus::BidPortfolio<cyclus::Material>());
+  for (it = bids.begin(); it != bids.end(); ++it) {
+    if ((*it)->offer()->quantity() >= min_qty) {
+      kept->AddBid((*it)->request(), (*it)->offer(), (*it)->bidder(),
+                   (*it)->exclusive(), (*it)->preference());
+    }
+  }
+  const std::set<cyclus::CapacityConstraint<cyclus::Material> >& constraints =
+      port->constraints();
+  std::set<cyclus::CapacityConstraint<cyclus::Material> >::const_iterator c;
+  for (c = constraints.begin(); c != constraints.end(); ++c) {
+    kept->AddConstraint(*c);
+  }
+  return kept;
+}
+
+/// Total quantity of the materials in responses
+double Shipped(const std::vector<std::pair<cyclus::Trade<cyclus::Material>,
+                                           cyclus::Material::Ptr> >& responses) {
+  double qty = 0;
+  for (size_t i = 0; i < responses.size(); ++i) {
+    qty += responses[i].second->quantity();
+  }
+  return qty;
+}
+
+}  // namespace
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+std::set<cyclus::BidPortfolio<cyclus::Material>::Ptr>
+ObservedSellPolicy::GetMatlBids(
+    cyclus::CommodMap<cyclus::Material>::type& commod_requests) {
+  if (pruned_ && gate_ && !gate_()) {
+    return std::set<cyclus::BidPortfolio<cyclus::Material>::Ptr>();
+  }
+  if (observer_) {
+    cyclus::CommodMap<cyclus::Material>::type::iterator it =
+        commod_requests.find(commod_);
+    if (it != commod_requests.end() && !it->second.empty()) {
+      observer_();
+    }
+  }
+  std::set<cyclus::BidPortfolio<cyclus::Material>::Ptr> ports =
+      cyclus::toolkit::MatlSellPolicy::GetMatlBids(commod_requests);
+  if (min_shipment_ > 0) {
+    std::set<cyclus::BidPortfolio<cyclus::Material>::Ptr> shipments;
+    std::set<cyclus::BidPortfolio<cyclus::Material>::Ptr>::iterator it;
+    for (it = ports.begin(); it != ports.end(); ++it) {
+      cyclus::BidPortfolio<cyclus::Material>::Ptr port =
+          DropSmallBids(*it, min_shipment_);
+      if (!port->bids().empty()) {
+        shipments.insert(port);
+      }
+    }
+    ports.swap(shipments);
+  }
+  if (pruned_) {
+    DropSmall(ports, threshold_, &MaxOffered);
+  }
+  if (counter_ != NULL) {
+    counter_->Bids(policy_, ports);
+  }
+  return ports;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void ObservedSellPolicy::GetMatlTrades(
+    const std::vector<cyclus::Trade<cyclus::Material> >& trades,
+    std::vector<std::pair<cyclus::Trade<cyclus::Material>,
+                          cyclus::Material::Ptr> >& responses) {
+  if (trade_observer_ && !trades.empty()) {
+    trade_observer_();
+  }
+  if (counter_ != NULL) {
+    counter_->Sold(policy_, trades);
+  }
+  cyclus::toolkit::MatlSellPolicy::GetMatlTrades(trades, responses);
+  if (shipment_observer_ && !responses.empty()) {
+    shipment_observer_(Shipped(responses));
+  }
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+std::set<cyclus::RequestPortfolio<cyclus::Material>::Ptr>
+ObservedBuyPolicy::GetMatlRequests() {
+  // The base policy is always asked, so that its active/dormant cycle keeps
+  // counting time steps while the gate is closed
+  std::set<cyclus::RequestPortfolio<cyclus::Material>::Ptr> ports =
+      cyclus::toolkit::MatlBuyPolicy::GetMatlRequests();
+  int pruned = 0;
+  if (schedule_ && !schedule_()) {
+    ports.clear();
+  } else if (pruned_) {
+    pruned = NumRequests(ports);
+    if (gate_ && !gate_()) {
+      ports.clear();
+    } else {
+      DropSmall(ports, threshold_, &MaxRequested);
+    }
+    pruned -= NumRequests(ports);
+  }
+  if (counter_ != NULL) {
+    counter_->Requests(policy_, ports, pruned);
+  }
+  return ports;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void ObservedBuyPolicy::AcceptMatlTrades(
+    const std::vector<std::pair<cyclus::Trade<cyclus::Material>,
+                                cyclus::Material::Ptr> >& responses) {
+  if (counter_ != NULL) {
+    counter_->Bought(policy_, responses);
+  }
+  cyclus::toolkit::MatlBuyPolicy::AcceptMatlTrades(responses);
+  if (delivery_observer_ && !responses.empty()) {
+    delivery_observer_(Shipped(responses));
+  }
+}
+
+}  // namespace tricycle
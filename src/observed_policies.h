@@ -0,0 +1,143 @@
+#ifndef CYCLUS_TRICYCLE_OBSERVED_POLICIES_H_
+#define CYCLUS_TRICYCLE_OBSERVED_POLICIES_H_
+
+#include <functional>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "cyclus.h"
+#include "dre_counter.h"
+
+namespace tricycle {
+
+/// @class ObservedSellPolicy
+/// A MatlSellPolicy that gives its owner a chance to bring the sold buffer up
+/// to date right before bids are built. The observer is only called when
+/// there is at least one request for the watched commodity, so an agent with
+/// no demand for its product is never woken up by the exchange. A second
+/// observer can be called once trades have actually been accepted.
+///
+/// A pruned policy does not bid at all while its gate is closed, and drops
+/// bid portfolios that offer less than the prune threshold. Single bids
+/// below a minimum shipment size can be dropped as well.
+class ObservedSellPolicy : public cyclus::toolkit::MatlSellPolicy {
+ public:
+  typedef std::function<void()> Observer;
+  typedef std::function<void(double)> QuantityObserver;
+  typedef std::function<bool()> Gate;
+
+  ObservedSellPolicy()
+      : counter_(NULL), pruned_(false), threshold_(0), min_shipment_(0) {}
+
+  /// Calls observer before bidding whenever commod has outstanding requests
+  void Observe(std::string commod, Observer observer) {
+    commod_ = commod;
+    observer_ = observer;
+  }
+
+  /// Calls observer right before material is taken out of the buffer to
+  /// fill accepted trades
+  void ObserveTrades(Observer observer) { trade_observer_ = observer; }
+
+  /// Calls observer with the total quantity shipped once trades are filled
+  void ObserveShipments(QuantityObserver observer) {
+    shipment_observer_ = observer;
+  }
+
+  /// Counts the bids and trades of this policy as policy in counter
+  void Count(DreCounter* counter, std::string policy) {
+    counter_ = counter;
+    policy_ = policy;
+  }
+
+  /// Only bids while gate returns true, and only bid portfolios offering more
+  /// than threshold
+  void Prune(double threshold, Gate gate) {
+    pruned_ = true;
+    threshold_ = threshold;
+    gate_ = gate;
+  }
+
+  /// Drops every bid offering less than qty
+  void MinShipment(double qty) { min_shipment_ = qty; }
+
+  virtual std::set<cyclus::BidPortfolio<cyclus::Material>::Ptr> GetMatlBids(
+      cyclus::CommodMap<cyclus::Material>::type& commod_requests);
+
+  virtual void GetMatlTrades(
+      const std::vector<cyclus::Trade<cyclus::Material> >& trades,
+      std::vector<std::pair<cyclus::Trade<cyclus::Material>,
+                            cyclus::Material::Ptr> >& responses);
+
+ private:
+  std::string commod_;
+  Observer observer_;
+  Observer trade_observer_;
+  QuantityObserver shipment_observer_;
+  DreCounter* counter_;
+  std::string policy_;
+  bool pruned_;
+  double threshold_;
+  Gate gate_;
+  double min_shipment_;
+};
+
+/// @class ObservedBuyPolicy
+/// A MatlBuyPolicy whose requests and accepted trades can be counted. A
+/// pruned policy does not request at all while its gate is closed, and drops
+/// request portfolios asking for less than the prune threshold. A scheduled
+/// policy only requests on the time steps its schedule allows.
+class ObservedBuyPolicy : public cyclus::toolkit::MatlBuyPolicy {
+ public:
+  typedef std::function<void(double)> QuantityObserver;
+  typedef std::function<bool()> Gate;
+
+  ObservedBuyPolicy() : counter_(NULL), pruned_(false), threshold_(0) {}
+
+  /// Counts the requests and trades of this policy as policy in counter
+  void Count(DreCounter* counter, std::string policy) {
+    counter_ = counter;
+    policy_ = policy;
+  }
+
+  /// Calls observer with the total quantity received when trades are
+  /// accepted
+  void ObserveDeliveries(QuantityObserver observer) {
+    delivery_observer_ = observer;
+  }
+
+  /// Only requests while gate returns true, and only request portfolios
+  /// asking for more than threshold
+  void Prune(double threshold, Gate gate) {
+    pruned_ = true;
+    threshold_ = threshold;
+    gate_ = gate;
+  }
+
+  /// Only requests on the time steps for which active returns true. Unlike
+  /// the base policy's active/dormant cycle, the schedule can be computed
+  /// from the agent's saved state and so survives a restart.
+  void Schedule(Gate active) { schedule_ = active; }
+
+  virtual std::set<cyclus::RequestPortfolio<cyclus::Material>::Ptr>
+  GetMatlRequests();
+
+  virtual void AcceptMatlTrades(
+      const std::vector<std::pair<cyclus::Trade<cyclus::Material>,
+                                  cyclus::Material::Ptr> >& responses);
+
+ private:
+  QuantityObserver delivery_observer_;
+  DreCounter* counter_;
+  std::string policy_;
+  bool pruned_;
+  double threshold_;
+  Gate gate_;
+  Gate schedule_;
+};
+
+}  // namespace tricycle
+
+#endif  // CYCLUS_TRICYCLE_OBSERVED_POLICIES_H_
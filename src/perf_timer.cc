@@ -0,0 +1,120 @@
+// perf_timer.cc
+
+#include "perf_timer.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+
+namespace tricycle {
+
+namespace {
+
+/// Chrome trace file shared by every agent, opened on the first span and
+/// closed at exit. The trace viewers also load the file of a run that was
+/// killed, whose event array is never closed.
+class TraceFile {
+ public:
+  static TraceFile& Instance() {
+    static TraceFile instance;
+    return instance;
+  }
+
+  bool enabled() const { return file_ != NULL; }
+
+  void Span(cyclus::Agent* agent, const char* phase,
+            PerfLog::Clock::time_point begin, PerfLog::Clock::time_point end) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    double ts = Micros(begin - epoch_);
+    double dur = Micros(end - begin);
+    std::fprintf(file_,
+                 "%s{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":0,"
+                 "\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f,"
+                 "\"args\":{\"time\":%d}}",
+                 first_ ? "" : ",\n", phase, agent->prototype().c_str(),
+                 agent->id(), ts, dur, agent->context()->time());
+    first_ = false;
+  }
+
+ private:
+  TraceFile() : file_(NULL), first_(true), epoch_(PerfLog::Clock::now()) {
+    const char* path = std::getenv("TRICYCLE_PERF_TRACE");
+    if (path != NULL && *path != '\0') {
+      file_ = std::fopen(path, "w");
+    }
+    if (file_ != NULL) {
+      std::fputs("[\n", file_);
+    }
+  }
+
+  ~TraceFile() {
+    if (file_ != NULL) {
+      std::fputs("\n]\n", file_);
+      std::fclose(file_);
+    }
+  }
+
+  static double Micros(PerfLog::Clock::duration d) {
+    return std::chrono::duration<double, std::micro>(d).count();
+  }
+
+  std::FILE* file_;
+  bool first_;
+  PerfLog::Clock::time_point epoch_;
+  std::mutex mutex_;
+};
+
+}  // namespace
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+PerfLog::PerfLog() : agent_(NULL) {}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void PerfLog::Init(cyclus::Agent* agent) {
+  agent_ = agent;
+  stats_.clear();
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void PerfLog::Add(const char* phase, Clock::time_point begin,
+                  Clock::time_point end) {
+  double secs = std::chrono::duration<double>(end - begin).count();
+  Stats& s = stats_[phase];
+  s.min = s.calls == 0 ? secs : std::min(s.min, secs);
+  s.max = std::max(s.max, secs);
+  s.total += secs;
+  ++s.calls;
+
+  TraceFile& trace = TraceFile::Instance();
+  if (trace.enabled()) {
+    trace.Span(agent_, phase, begin, end);
+  }
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void PerfLog::EndStep() {
+  cyclus::Context* ctx = agent_->context();
+  if (ctx->time() >= ctx->sim_info().duration - 1) {
+    Flush();
+  }
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void PerfLog::Flush() {
+  std::map<std::string, Stats>::iterator it;
+  for (it = stats_.begin(); it != stats_.end(); ++it) {
+    agent_->context()
+        ->NewDatum("TricyclePerf")
+        ->AddVal("AgentId", agent_->id())
+        ->AddVal("Phase", it->first)
+        ->AddVal("Calls", it->second.calls)
+        ->AddVal("Total", it->second.total)
+        ->AddVal("Min", it->second.min)
+        ->AddVal("Max", it->second.max)
+        ->Record();
+  }
+  stats_.clear();
+}
+
+}  // namespace tricycle
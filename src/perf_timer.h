@@ -0,0 +1,86 @@
+#ifndef CYCLUS_TRICYCLE_PERF_TIMER_H_
+#define CYCLUS_TRICYCLE_PERF_TIMER_H_
+
+#include <chrono>
+#include <map>
+#include <string>
+
+#include "cyclus.h"
+
+namespace tricycle {
+
+/// @class PerfLog
+/// Wall time spent by one agent in each of its phases (e.g. the steps of
+/// Tick). Aggregates are written to the TricyclePerf table on the last time
+/// step of the simulation, or when the agent is decommissioned:
+///  - AgentId, Phase
+///  - Calls, Total, Min and Max (wall time in seconds)
+///
+/// If the TRICYCLE_PERF_TRACE environment variable names a file, every timed
+/// span is also appended to it in Chrome trace format (one track per agent,
+/// viewable in chrome://tracing or Perfetto).
+///
+/// Phases are only timed when tricycle is built with TRICYCLE_PERF, otherwise
+/// the TRICYCLE_PERF_* macros expand to nothing.
+class PerfLog {
+ public:
+  typedef std::chrono::steady_clock Clock;
+
+  PerfLog();
+
+  void Init(cyclus::Agent* agent);
+
+  /// Adds a span of phase to the aggregates (and the trace)
+  void Add(const char* phase, Clock::time_point begin, Clock::time_point end);
+
+  /// Writes the aggregates if this is the last time step
+  void EndStep();
+
+  /// Writes the aggregates and starts over
+  void Flush();
+
+ private:
+  struct Stats {
+    Stats() : calls(0), total(0), min(0), max(0) {}
+    int calls;
+    double total;
+    double min;
+    double max;
+  };
+
+  cyclus::Agent* agent_;
+  std::map<std::string, Stats> stats_;
+};
+
+/// Adds the time from construction to destruction to a PerfLog
+class PerfScope {
+ public:
+  PerfScope(PerfLog* log, const char* phase)
+      : log_(log), phase_(phase), begin_(PerfLog::Clock::now()) {}
+
+  ~PerfScope() { log_->Add(phase_, begin_, PerfLog::Clock::now()); }
+
+ private:
+  PerfLog* log_;
+  const char* phase_;
+  PerfLog::Clock::time_point begin_;
+};
+
+}  // namespace tricycle
+
+#define TRICYCLE_PERF_CAT_(a, b) a##b
+#define TRICYCLE_PERF_CAT(a, b) TRICYCLE_PERF_CAT_(a, b)
+
+#ifdef TRICYCLE_PERF
+/// Times the rest of the enclosing block as phase
+#define TRICYCLE_PERF_SCOPE(log, phase) \
+  tricycle::PerfScope TRICYCLE_PERF_CAT(perf_scope_, __LINE__)(&(log), phase)
+#define TRICYCLE_PERF_END_STEP(log) (log).EndStep()
+#define TRICYCLE_PERF_FLUSH(log) (log).Flush()
+#else
+#define TRICYCLE_PERF_SCOPE(log, phase)
+#define TRICYCLE_PERF_END_STEP(log)
+#define TRICYCLE_PERF_FLUSH(log)
+#endif
+
+#endif  // CYCLUS_TRICYCLE_PERF_TIMER_H_
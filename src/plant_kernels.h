@@ -0,0 +1,151 @@
+#ifndef CYCLUS_TRICYCLE_PLANT_KERNELS_H_
+#define CYCLUS_TRICYCLE_PLANT_KERNELS_H_
+
+#include <algorithm>
+#include <cmath>
+
+#include "nuclide_data.h"
+
+// Tritium balance of a single fusion power plant, written as small inline
+// kernels on plain numbers. FusionPowerPlant applies them to one plant at a
+// time; FusionFleet applies them in loops over its per-plant arrays, which
+// the compiler is free to vectorize. The kernels of the balance itself are
+// templated on their number type, so that PlantSensitivity can run them on
+// dual numbers. Nothing in here depends on cyclus.
+
+namespace tricycle {
+
+/// Fraction of tritium atoms remaining after secs seconds
+inline double TritiumSurvival(double secs) {
+  return std::exp(-std::log(2.0) * secs / kTritiumHalfLife);
+}
+
+/// Larger of a and b, for doubles and duals alike
+template <class T>
+inline T Max(const T& a, const T& b) {
+  return a < b ? b : a;
+}
+
+/// Moves the decayed part of a tritium inventory over to helium-3, given the
+/// surviving fraction for the elapsed time
+template <class T>
+inline void DecayStep(double surviving, T* tritium, T* helium3) {
+  T decayed = *tritium * (1 - surviving);
+  *tritium -= decayed;
+  *helium3 += decayed;
+}
+
+/// Tritium still missing from the sequestered inventory
+template <class T>
+inline T SequesteredGap(const T& sequestered_equilibrium,
+                        const T& sequestered_tritium) {
+  return Max(sequestered_equilibrium - sequestered_tritium, T(0));
+}
+
+/// Storage a plant keeps on hand: the reserve, but never less than one time
+/// step's worth of fuel. The reserve is a plain quantity, while a time
+/// step's burn grows with dt; without the floor a plant on long time steps
+/// could not start up or refill what it burns in one step.
+template <class T>
+inline T StepReserve(const T& reserve_inventory, const T& fuel_usage_mass) {
+  return Max(reserve_inventory, fuel_usage_mass);
+}
+
+/// Tritium storage a plant needs before it can operate for a time step.
+/// Before the first startup only tritium_startup_fraction of the full
+/// reserve and sequestered inventory is required.
+template <class T>
+inline T RequiredStorage(bool started, const T& gap, const T& reserve_inventory,
+                         const T& tritium_startup_fraction,
+                         const T& fuel_usage_mass) {
+  if (!started) {
+    return (gap + reserve_inventory) * tritium_startup_fraction;
+  }
+  return gap + fuel_usage_mass;
+}
+
+/// Tritium in storage beyond the reserve and the sequestration gap
+template <class T>
+inline T ExcessStorage(const T& storage, const T& reserve_inventory,
+                       const T& gap) {
+  return Max(storage - (reserve_inventory + gap), T(0));
+}
+
+/// Change of a running plant's tritium storage over one time step, leaving
+/// decay of the storage itself aside: tritium bred minus tritium burned minus
+/// what goes to make up for decay of the sequestered inventory
+inline double ForecastNet(double fuel_usage_mass, double TBR,
+                          double sequestered_equilibrium, double surviving) {
+  return fuel_usage_mass * (TBR - 1) -
+         sequestered_equilibrium * (1 - surviving);
+}
+
+/// Tritium storage a running plant must hold now to stay at or above
+/// reserve_inventory for the next steps time steps without deliveries, if
+/// each time step the storage decays to surviving and then changes by net
+inline double ForecastStorage(double reserve_inventory, double net,
+                              double surviving, int steps) {
+  double need = reserve_inventory;
+  for (int i = 0; i < steps; ++i) {
+    need = std::max((need - net) / surviving, reserve_inventory);
+  }
+  return need;
+}
+
+/// Lithium burned and helium-4 generated in the blanket (kg)
+template <class T>
+struct BasicBreedingYield {
+  T li6;
+  T li7;
+  T he4;
+};
+typedef BasicBreedingYield<double> BreedingYield;
+
+/// Blanket consumption for breeding bred kg of tritium, where Li7_contribution
+/// is the fraction of tritium bred from Li-7
+template <class T>
+inline BasicBreedingYield<T> Breeding(const T& bred,
+                                      const T& Li7_contribution) {
+  T bred_atoms = bred * kTritiumMass;
+  BasicBreedingYield<T> yield;
+  yield.li7 = bred_atoms * Li7_contribution / kLithium7Mass;
+  yield.li6 = bred_atoms * (1 - Li7_contribution) / kLithium6Mass;
+  yield.he4 = bred_atoms / kHelium4Mass;
+  return yield;
+}
+
+/// Number of blanket turnovers falling in time step time, for a turnover
+/// every period seconds and time steps of dt seconds. With dt equal to the
+/// period this is 1 on every time step after the first; with time steps
+/// longer than the period several turnovers fall in one time step.
+inline int BlanketCycles(int time, double period, double dt) {
+  if (time <= 0 || period <= 0) {
+    return 0;
+  }
+  // The offset keeps exact multiples of the period from rounding down
+  return static_cast<int>(std::floor(time * dt / period + 1e-9) -
+                          std::floor((time - 1) * dt / period + 1e-9));
+}
+
+/// Blanket mass swapped out in a time step with cycles turnovers of turnover
+/// kg each; never more than the whole blanket
+inline double BlanketTurnover(int cycles, double turnover,
+                              double blanket_size) {
+  return std::min(cycles * turnover, blanket_size);
+}
+
+/// Whole time steps of dt seconds nearest to period seconds, and at least one
+inline int PeriodSteps(double period, double dt) {
+  return std::max(1, static_cast<int>(std::lround(period / dt)));
+}
+
+/// Quantity each purchase of a schedule buying quantity every period seconds
+/// takes, when purchases are made every steps time steps of dt seconds
+inline double ScheduledQuantity(double quantity, double period, int steps,
+                                double dt) {
+  return quantity * steps * dt / period;
+}
+
+}  // namespace tricycle
+
+#endif  // CYCLUS_TRICYCLE_PLANT_KERNELS_H_
@@ -0,0 +1,149 @@
+// plant_sensitivity.cc
+
+#include "plant_sensitivity.h"
+
+#include <cmath>
+
+#include "plant_kernels.h"
+
+namespace tricycle {
+
+namespace {
+
+// Same as cyclus::eps_rsrc(), below which FusionPowerPlant ignores a
+// quantity
+constexpr double kEps = 1e-6;
+
+/// Keeps x's value but takes over the derivatives of from
+void TakeDerivatives(PlantSensitivity::Scalar* x,
+                     const PlantSensitivity::Scalar& from) {
+  double value = x->v;
+  *x = from;
+  x->v = value;
+}
+
+}  // namespace
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+PlantSensitivity::PlantSensitivity() {}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void PlantSensitivity::Init(double TBR, double reserve_inventory,
+                            double Li7_contribution, double burn_rate,
+                            double fuel_usage_mass,
+                            double sequestered_equilibrium) {
+  TBR_ = Scalar::Variable(TBR, kTBR);
+  reserve_inventory_ = Scalar::Variable(reserve_inventory, kReserveInventory);
+  Li7_contribution_ = Scalar::Variable(Li7_contribution, kLi7Contribution);
+  // Fuel usage is proportional to the burn rate
+  fuel_usage_mass_ = Scalar(fuel_usage_mass);
+  fuel_usage_mass_.d[kBurnRate] = fuel_usage_mass / burn_rate;
+  sequestered_equilibrium_ = Scalar(sequestered_equilibrium);
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void PlantSensitivity::Sync(double storage, double excess,
+                            double sequestered_tritium,
+                            double sequestered_helium3) {
+  storage_.v = storage;
+  excess_.v = excess;
+  sequestered_.v = sequestered_tritium;
+  sequestered_he3_.v = sequestered_helium3;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void PlantSensitivity::Decay(double surviving) {
+  // The helium-3 of the storage and excess is extracted right away
+  Scalar helium3;
+  DecayStep(surviving, &storage_, &helium3);
+  DecayStep(surviving, &excess_, &helium3);
+  DecayStep(surviving, &sequestered_, &sequestered_he3_);
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void PlantSensitivity::Operate() {
+  Scalar gap = SequesteredGap(sequestered_equilibrium_, sequestered_);
+  if (gap.v > kEps) {
+    storage_ -= gap;
+    sequestered_ += gap;
+  }
+
+  storage_ -= fuel_usage_mass_;
+  Scalar bred = fuel_usage_mass_ * TBR_;
+  BasicBreedingYield<Scalar> yield = Breeding(bred, Li7_contribution_);
+  storage_ += bred;
+  lithium_ += yield.li6 + yield.li7;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void PlantSensitivity::MoveExcess() {
+  Scalar gap = SequesteredGap(sequestered_equilibrium_, sequestered_);
+  Scalar excess = ExcessStorage(storage_, reserve_inventory_, gap);
+  if (excess.v > kEps) {
+    storage_ -= excess;
+    excess_ += excess;
+  }
+}
+
+void PlantSensitivity::MoveExcess(double quantity) {
+  if (quantity > kEps) {
+    storage_ -= Scalar(quantity);
+    excess_ += Scalar(quantity);
+  }
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void PlantSensitivity::Deliver(double quantity, const Scalar& target) {
+  if (quantity <= 0) {
+    return;
+  }
+  storage_.v += quantity;
+  if (std::fabs(storage_.v - target.v) <= kEps) {
+    TakeDerivatives(&storage_, target);
+  }
+}
+
+void PlantSensitivity::Deliver(double quantity) {
+  if (quantity > 0) {
+    storage_.v += quantity;
+  }
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void PlantSensitivity::Sell(double quantity) {
+  if (quantity <= 0) {
+    return;
+  }
+  excess_.v -= quantity;
+  if (excess_.v <= kEps) {
+    excess_ = Scalar(excess_.v);
+  }
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+std::vector<double> PlantSensitivity::Derivatives() const {
+  Scalar inventories[] = {storage_, excess_, sequestered(), lithium_};
+  std::vector<double> out;
+  for (const Scalar& x : inventories) {
+    for (int p = 0; p < kNumParams; ++p) {
+      out.push_back(x.d[p]);
+    }
+  }
+  return out;
+}
+
+std::vector<std::string> PlantSensitivity::Columns() {
+  const char* inventories[] = {"TritiumStorage", "TritiumExcess",
+                               "TritiumSequestered", "LithiumBurned"};
+  const char* params[] = {"TBR", "ReserveInventory", "Li7Contribution",
+                          "BurnRate"};
+  std::vector<std::string> out;
+  for (const char* x : inventories) {
+    for (const char* p : params) {
+      out.push_back(std::string("d") + x + "_d" + p);
+    }
+  }
+  return out;
+}
+
+}  // namespace tricycle
@@ -0,0 +1,105 @@
+#ifndef CYCLUS_TRICYCLE_PLANT_SENSITIVITY_H_
+#define CYCLUS_TRICYCLE_PLANT_SENSITIVITY_H_
+
+#include <string>
+#include <vector>
+
+#include "dual.h"
+
+namespace tricycle {
+
+/// @class PlantSensitivity
+/// Forward-mode derivatives of a fusion power plant's inventories with
+/// respect to TBR, reserve_inventory, Li7_contribution and the burn rate
+/// (kg/GW-y, which sets the tritium burned per time step). It replays the
+/// steps of FusionPowerPlant::Tick and the exchange on dual numbers, through
+/// the same plant_kernels.h kernels, so one run gives the derivatives along
+/// the whole trajectory.
+///
+/// Which branch each step takes (whether the plant operates, whether a
+/// delivery filled it up) comes from the plant. Sync takes the plant's
+/// actual inventories over at the start of every time step, keeping the
+/// derivatives, so the values never drift from the simulated ones. Nothing
+/// in here depends on cyclus.
+class PlantSensitivity {
+ public:
+  enum Param {
+    kTBR,
+    kReserveInventory,
+    kLi7Contribution,
+    kBurnRate,
+    kNumParams
+  };
+  typedef Dual<kNumParams> Scalar;
+
+  PlantSensitivity();
+
+  /// Sets the parameters the derivatives are taken with respect to
+  void Init(double TBR, double reserve_inventory, double Li7_contribution,
+            double burn_rate, double fuel_usage_mass,
+            double sequestered_equilibrium);
+
+  /// Takes the plant's inventories (kg) over, keeping their derivatives
+  void Sync(double storage, double excess, double sequestered_tritium,
+            double sequestered_helium3);
+
+  /// Decay of every inventory, with the helium-3 of the storage and excess
+  /// extracted
+  void Decay(double surviving);
+
+  /// Fills the sequestered inventory up, then burns and breeds a time step's
+  /// fuel
+  void Operate();
+
+  /// Moves tritium beyond the reserve and the sequestration gap to excess
+  void MoveExcess();
+
+  /// Moves a fixed quantity to excess, when the plant sized the move by
+  /// other means than the reserve
+  void MoveExcess(double quantity);
+
+  /// Fuel delivered by the exchange. A delivery that brought the storage up
+  /// to target, the fill level of the policy that asked for it, leaves the
+  /// storage with target's derivatives; any other delivery is a fixed
+  /// quantity.
+  void Deliver(double quantity, const Scalar& target);
+  void Deliver(double quantity);
+
+  /// Excess tritium sold. Selling all of it leaves nothing to differentiate.
+  void Sell(double quantity);
+
+  const Scalar& storage() const { return storage_; }
+  const Scalar& excess() const { return excess_; }
+  Scalar sequestered() const { return sequestered_ + sequestered_he3_; }
+  /// Lithium-6 and lithium-7 burned in the blanket so far
+  const Scalar& lithium() const { return lithium_; }
+
+  const Scalar& reserve_inventory() const { return reserve_inventory_; }
+  double sequestered_equilibrium() const {
+    return Value(sequestered_equilibrium_);
+  }
+
+  /// Derivatives of storage, excess, sequestered and lithium, each with
+  /// respect to every parameter, in the order of Columns
+  std::vector<double> Derivatives() const;
+
+  /// Column names of Derivatives, e.g. dTritiumStorage_dTBR
+  static std::vector<std::string> Columns();
+
+ private:
+  Scalar TBR_;
+  Scalar reserve_inventory_;
+  Scalar Li7_contribution_;
+  Scalar fuel_usage_mass_;
+  Scalar sequestered_equilibrium_;
+
+  Scalar storage_;
+  Scalar excess_;
+  Scalar sequestered_;
+  Scalar sequestered_he3_;
+  Scalar lithium_;
+};
+
+}  // namespace tricycle
+
+#endif  // CYCLUS_TRICYCLE_PLANT_SENSITIVITY_H_
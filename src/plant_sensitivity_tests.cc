@@ -0,0 +1,118 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <vector>
+
+#include "plant_kernels.h"
+#include "plant_sensitivity.h"
+
+namespace tricycle {
+namespace {
+
+typedef PlantSensitivity::Scalar Scalar;
+
+struct Params {
+  double TBR = 1.08;
+  double reserve_inventory = 6.0;
+  double Li7_contribution = 0.03;
+  double burn_rate = 55.8;
+};
+
+// A plant that operates on every time step of a month, refilled to its
+// reserve whenever it falls below it, without Sync
+PlantSensitivity RunPlant(const Params& p, int steps) {
+  double fuel_usage_mass = p.burn_rate * 0.3 / 12;
+  PlantSensitivity plant;
+  plant.Init(p.TBR, p.reserve_inventory, p.Li7_contribution, p.burn_rate,
+             fuel_usage_mass, 2.121);
+  Scalar startup = plant.reserve_inventory() + 2.121;
+  plant.Deliver(startup.v, startup);
+
+  double surviving = TritiumSurvival(2629846);
+  for (int t = 0; t < steps; ++t) {
+    plant.Decay(surviving);
+    plant.Operate();
+    plant.MoveExcess();
+    const Scalar& target = plant.reserve_inventory();
+    if (plant.storage().v < target.v) {
+      plant.Deliver(target.v - plant.storage().v, target);
+    }
+  }
+  return plant;
+}
+
+}  // namespace
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+TEST(PlantSensitivityTest, DualArithmetic) {
+  typedef Dual<2> D;
+  D x = D::Variable(3, 0);
+  D y = D::Variable(2, 1);
+  D f = (x * y + 1.0) / y - x;  // x + 1 / y - x = 1 / y
+
+  EXPECT_DOUBLE_EQ(0.5, f.v);
+  EXPECT_NEAR(0, f.d[0], 1e-15);
+  EXPECT_DOUBLE_EQ(-0.25, f.d[1]);
+
+  EXPECT_DOUBLE_EQ(3, Max(x, y).v);
+  EXPECT_DOUBLE_EQ(1, Max(x, y).d[0]);
+  EXPECT_DOUBLE_EQ(0, Max(x - 5.0, D(0)).d[0]);
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+TEST(PlantSensitivityTest, MatchesFiniteDifferences) {
+  int steps = 24;
+  Params base;
+  PlantSensitivity plant = RunPlant(base, steps);
+  std::vector<double> derivs = plant.Derivatives();
+
+  // Central differences of every inventory for every parameter
+  for (int p = 0; p < PlantSensitivity::kNumParams; ++p) {
+    Params up = base;
+    Params down = base;
+    double* up_param[] = {&up.TBR, &up.reserve_inventory,
+                          &up.Li7_contribution, &up.burn_rate};
+    double* down_param[] = {&down.TBR, &down.reserve_inventory,
+                            &down.Li7_contribution, &down.burn_rate};
+    double h = 1e-5 * *up_param[p];
+    *up_param[p] += h;
+    *down_param[p] -= h;
+    PlantSensitivity hi = RunPlant(up, steps);
+    PlantSensitivity lo = RunPlant(down, steps);
+
+    double hi_values[] = {hi.storage().v, hi.excess().v, hi.sequestered().v,
+                          hi.lithium().v};
+    double lo_values[] = {lo.storage().v, lo.excess().v, lo.sequestered().v,
+                          lo.lithium().v};
+    for (int x = 0; x < 4; ++x) {
+      double fd = (hi_values[x] - lo_values[x]) / (2 * h);
+      double ad = derivs[x * PlantSensitivity::kNumParams + p];
+      EXPECT_NEAR(fd, ad, 1e-6 * (1 + std::abs(fd)))
+          << PlantSensitivity::Columns()[x * PlantSensitivity::kNumParams + p];
+    }
+  }
+
+  // Held at the reserve, so the storage moves one for one with it
+  EXPECT_NEAR(1, derivs[PlantSensitivity::kReserveInventory], 1e-12);
+  // A TBR above one only ever adds to the excess
+  EXPECT_LT(0, derivs[PlantSensitivity::kNumParams + PlantSensitivity::kTBR]);
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+TEST(PlantSensitivityTest, SyncKeepsDerivatives) {
+  PlantSensitivity plant = RunPlant(Params(), 3);
+  std::vector<double> before = plant.Derivatives();
+  plant.Sync(6.5, 1.0, 2.0, 0.1);
+
+  EXPECT_DOUBLE_EQ(6.5, plant.storage().v);
+  EXPECT_DOUBLE_EQ(2.1, plant.sequestered().v);
+  EXPECT_EQ(before, plant.Derivatives());
+
+  plant.Sell(1.0);
+  EXPECT_DOUBLE_EQ(0, plant.excess().v);
+  for (int p = 0; p < PlantSensitivity::kNumParams; ++p) {
+    EXPECT_EQ(0, plant.excess().d[p]);
+  }
+}
+
+}  // namespace tricycle
@@ -0,0 +1,281 @@
+// tricycle_bench.cc
+//
+// Microbenchmarks of the archetype hot paths, built as the tricycle_bench
+// target when google-benchmark is available. For machine-readable results
+// run
+//
+//   tricycle_bench --benchmark_format=json --benchmark_out=bench.json
+//
+// Agents are driven directly on a bare cyclus::Context, whose time stays at
+// 0. Decay is exercised by winding the agents' last decay time back before
+// each iteration; the blanket turnover branch is not reachable at time 0, so
+// CycleBlanket is timed loading a whole blanket.
+
+#include <benchmark/benchmark.h>
+
+#include <string>
+
+#include "cyclus.h"
+#include "decay_storage.h"
+#include "fusion_power_plant.h"
+#include "nuclides.h"
+
+using cyclus::CompMap;
+using cyclus::Composition;
+using cyclus::Material;
+
+namespace tricycle {
+
+// Inventory compositions the benchmarks are run with
+enum BenchComp { kPure = 0, kDecayed = 1, kImpure = 2 };
+
+Composition::Ptr BenchComposition(int kind) {
+  CompMap m;
+  m[kTritiumId] = 1.0;
+  if (kind == kDecayed) {
+    m[kHelium3Id] = 0.05;
+  } else if (kind == kImpure) {
+    m[kHelium3Id] = 0.05;
+    m[kLithium7Id] = 0.01;
+  }
+  return Composition::CreateFromMass(m);
+}
+
+Composition::Ptr BenchLithium() {
+  CompMap m;
+  m[kLithium6Id] = 0.3;
+  m[kLithium7Id] = 0.7;
+  return Composition::CreateFromAtom(m);
+}
+
+/// Owns a context for agents that are not part of a running simulation
+class BenchContext {
+ public:
+  BenchContext() : ctx_(&timer_, &recorder_) {
+    timer_.Initialize(&ctx_, cyclus::SimInfo(1200));
+  }
+
+  cyclus::Context* get() { return &ctx_; }
+
+ private:
+  cyclus::Timer timer_;
+  cyclus::Recorder recorder_;
+  cyclus::Context ctx_;
+};
+
+/// Sets up and refills FusionPowerPlant internals between iterations
+class FusionPowerPlantBench {
+ public:
+  static FusionPowerPlant* Create(cyclus::Context* ctx) {
+    FusionPowerPlant* fpp = new FusionPowerPlant(ctx);
+    fpp->fusion_power = 300;
+    fpp->TBR = 1.08;
+    fpp->reserve_inventory = 6.0;
+    fpp->sequestered_equilibrium = 2.121;
+    fpp->tritium_startup_fraction = 0.9;
+    fpp->fuel_incommod = "Tritium";
+    fpp->fuel_outcommod = "";
+    fpp->Li7_contribution = 0.03;
+    fpp->refuel_mode = "fill";
+    fpp->buy_quantity = 0.1;
+    fpp->buy_frequency = 1;
+    fpp->he3_outcommod = "Helium_3";
+    fpp->blanket_incommod = "Enriched_Lithium";
+    fpp->blanket_outcommod = "Depleted_Lithium";
+    fpp->blanket_size = 1000;
+    fpp->blanket_turnover_fraction = 0.05;
+    fpp->blanket_turnover_frequency = 1;
+    fpp->EnterNotify();
+    return fpp;
+  }
+
+  /// Tops tritium storage up to storage kg of the given composition and
+  /// the blanket feed up to a full blanket
+  static void Refill(FusionPowerPlant* fpp, double storage, int kind) {
+    fpp->storage_inventory.Sync();
+    double missing = storage - fpp->tritium_storage.quantity();
+    if (missing > cyclus::eps_rsrc()) {
+      fpp->tritium_storage.Push(
+          Material::CreateUntracked(missing, BenchComposition(kind)));
+    }
+    double feed = fpp->blanket_size - fpp->blanket_feed.quantity();
+    if (feed > cyclus::eps_rsrc()) {
+      fpp->blanket_feed.Push(Material::CreateUntracked(feed, BenchLithium()));
+    }
+    fpp->storage_inventory.Sync();
+  }
+
+  /// Makes the next Tick decay the inventories by dt time steps
+  static void Age(FusionPowerPlant* fpp, int dt) {
+    fpp->decay_time = fpp->context()->time() - dt;
+  }
+
+  static void Decay(FusionPowerPlant* fpp, int dt) {
+    fpp->storage_inventory.Decay(dt, kDefaultTimeStepDur);
+    fpp->excess_inventory.Decay(dt, kDefaultTimeStepDur);
+  }
+};
+
+/// Sets up and refills DecayStorage internals between iterations
+class DecayStorageBench {
+ public:
+  static DecayStorage* Create(cyclus::Context* ctx, bool lazy) {
+    DecayStorage* storage = new DecayStorage(ctx);
+    storage->incommod = "Tritium";
+    storage->outcommod = "Tritium_Out";
+    storage->throughput = cyclus::CY_LARGE_DOUBLE;
+    storage->max_tritium_inventory = cyclus::CY_LARGE_DOUBLE;
+    storage->lazy_decay = lazy;
+    storage->EnterNotify();
+    return storage;
+  }
+
+  static void Refill(DecayStorage* storage, double qty, int kind) {
+    storage->storage_inventory.Sync();
+    double missing = qty - storage->tritium_storage.quantity();
+    if (missing > cyclus::eps_rsrc()) {
+      storage->tritium_storage.Push(
+          Material::CreateUntracked(missing, BenchComposition(kind)));
+    }
+    // Pretend a time step went by since the last normalization
+    storage->decay_epoch = storage->context()->time() - 1;
+  }
+};
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// Benchmarks are parameterized by inventory size (kg) and BenchComp
+static void InventoryArgs(benchmark::internal::Benchmark* b) {
+  for (int kind = kPure; kind <= kImpure; ++kind) {
+    for (int kg : {10, 1000, 100000}) {
+      b->Args({kg, kind});
+    }
+  }
+}
+
+static void BM_FusionPowerPlantTick(benchmark::State& state) {
+  BenchContext ctx;
+  FusionPowerPlant* fpp = FusionPowerPlantBench::Create(ctx.get());
+  for (auto _ : state) {
+    state.PauseTiming();
+    FusionPowerPlantBench::Refill(fpp, state.range(0), state.range(1));
+    FusionPowerPlantBench::Age(fpp, 1);
+    state.ResumeTiming();
+    fpp->Tick();
+  }
+  delete fpp;
+}
+BENCHMARK(BM_FusionPowerPlantTick)->Apply(InventoryArgs);
+
+static void BM_FusionPowerPlantTock(benchmark::State& state) {
+  BenchContext ctx;
+  FusionPowerPlant* fpp = FusionPowerPlantBench::Create(ctx.get());
+  FusionPowerPlantBench::Refill(fpp, state.range(0), state.range(1));
+  for (auto _ : state) {
+    fpp->Tock();
+  }
+  delete fpp;
+}
+BENCHMARK(BM_FusionPowerPlantTock)->Apply(InventoryArgs);
+
+static void BM_BreedTritium(benchmark::State& state) {
+  BenchContext ctx;
+  FusionPowerPlant* fpp = FusionPowerPlantBench::Create(ctx.get());
+  FusionPowerPlantBench::Refill(fpp, state.range(0), state.range(1));
+  fpp->CycleBlanket();
+  int n = 0;
+  for (auto _ : state) {
+    // A fresh blanket every so often keeps the lithium from running out
+    if (++n % 1000 == 0) {
+      state.PauseTiming();
+      delete fpp;
+      fpp = FusionPowerPlantBench::Create(ctx.get());
+      FusionPowerPlantBench::Refill(fpp, state.range(0), state.range(1));
+      fpp->CycleBlanket();
+      state.ResumeTiming();
+    }
+    fpp->BreedTritium(0.05);
+  }
+  delete fpp;
+}
+BENCHMARK(BM_BreedTritium)->Apply(InventoryArgs);
+
+static void BM_ExtractHelium(benchmark::State& state) {
+  BenchContext ctx;
+  FusionPowerPlant* fpp = FusionPowerPlantBench::Create(ctx.get());
+  for (auto _ : state) {
+    state.PauseTiming();
+    FusionPowerPlantBench::Refill(fpp, state.range(0), state.range(1));
+    FusionPowerPlantBench::Decay(fpp, 1);
+    state.ResumeTiming();
+    fpp->ExtractHelium();
+  }
+  delete fpp;
+}
+BENCHMARK(BM_ExtractHelium)->Apply(InventoryArgs);
+
+static void BM_CycleBlanket(benchmark::State& state) {
+  // At time 0 CycleBlanket loads a whole blanket from the feed
+  BenchContext ctx;
+  for (auto _ : state) {
+    state.PauseTiming();
+    FusionPowerPlant* fpp = FusionPowerPlantBench::Create(ctx.get());
+    fpp->blanket_size = state.range(0);
+    FusionPowerPlantBench::Refill(fpp, 10, kPure);
+    state.ResumeTiming();
+    fpp->CycleBlanket();
+    state.PauseTiming();
+    delete fpp;
+    state.ResumeTiming();
+  }
+}
+BENCHMARK(BM_CycleBlanket)->Arg(100)->Arg(1000)->Arg(10000);
+
+static void BM_ReadyToOperate(benchmark::State& state) {
+  BenchContext ctx;
+  FusionPowerPlant* fpp = FusionPowerPlantBench::Create(ctx.get());
+  FusionPowerPlantBench::Refill(fpp, state.range(0), state.range(1));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(fpp->ReadyToOperate());
+  }
+  delete fpp;
+}
+BENCHMARK(BM_ReadyToOperate)->Apply(InventoryArgs);
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+static void StorageArgs(benchmark::internal::Benchmark* b) {
+  for (int lazy = 0; lazy <= 1; ++lazy) {
+    for (int kind = kPure; kind <= kImpure; ++kind) {
+      for (int kg : {10, 1000, 100000}) {
+        b->Args({kg, kind, lazy});
+      }
+    }
+  }
+}
+
+static void BM_DecayStorageTick(benchmark::State& state) {
+  BenchContext ctx;
+  DecayStorage* storage = DecayStorageBench::Create(ctx.get(), state.range(2));
+  for (auto _ : state) {
+    state.PauseTiming();
+    DecayStorageBench::Refill(storage, state.range(0), state.range(1));
+    state.ResumeTiming();
+    storage->Tick();
+  }
+  delete storage;
+}
+BENCHMARK(BM_DecayStorageTick)->Apply(StorageArgs);
+
+static void BM_DecayStorageTock(benchmark::State& state) {
+  BenchContext ctx;
+  DecayStorage* storage = DecayStorageBench::Create(ctx.get(), state.range(2));
+  DecayStorageBench::Refill(storage, state.range(0), state.range(1));
+  for (auto _ : state) {
+    storage->Tock();
+  }
+  delete storage;
+}
+BENCHMARK(BM_DecayStorageTock)->Apply(StorageArgs);
+
+}  // namespace tricycle
+
+BENCHMARK_MAIN();
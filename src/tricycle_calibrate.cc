@@ -0,0 +1,177 @@
+// tricycle_calibrate.cc
+//
+// Command line front end of Calibration: fits plant and market parameters
+// of a FuelCycleEngine run to one of the reference_data curves and prints
+// the fitted values. Without --fpp and --dep there are no plants, and the
+// market alone stands in for a candu_inputs scenario: the CANDU sources as
+// a constant supply that ends at --supply-end, the DecayStorage as the
+// market, and the sales Sink as --sales.
+//
+//   tricycle_calibrate
+//       --reference reference_data/AbdouTritiumDigitizationWebPlot.csv
+//       --start-year 2003 --duration 336 --initial 18.5 --sales 0.00833
+//       --fit external_supply=0:0.2 --fit supply_end=120:336
+
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "calibration.h"
+
+namespace {
+
+const char* kUsage =
+    "usage: tricycle_calibrate --reference FILE --duration STEPS\n"
+    "                          --fit NAME=LOWER:UPPER[:START] [--fit ...]\n"
+    "                          [--start-year YEAR] [--fpp FILE --dep FILE]\n"
+    "                          [--dt SECONDS] [--initial KG] [--supply KG]\n"
+    "                          [--supply-end STEP] [--sales KG]\n"
+    "                          [--throughput KG] [--capacity KG]\n"
+    "                          [--keep-excess] [--max-evals N] [--out FILE]\n"
+    "\n"
+    "  --reference   curve to fit, reference_data format\n"
+    "  --duration    time steps to run\n"
+    "  --fit         parameter to fit within bounds, optionally from START.\n"
+    "                Plant parameters (all plants, or PROTOTYPE.NAME):\n"
+    "                fusion_power, TBR, reserve_inventory,\n"
+    "                sequestered_equilibrium, tritium_startup_fraction,\n"
+    "                Li7_contribution, buy_quantity. Market parameters:\n"
+    "                initial_inventory, external_supply, supply_end, sales,\n"
+    "                throughput, capacity. supply_end is a time step:\n"
+    "                it is fitted by trying each whole step within its\n"
+    "                bounds, and reported as one\n"
+    "  --start-year  year the first time step starts at (default: 2003)\n"
+    "  --fpp         plant designs, FPPInput.csv format\n"
+    "  --dep         deployment schedule, DeployIn.csv format\n"
+    "  --max-evals   most engine runs (default: 5000)\n"
+    "  --out         csv file for the totals of the fitted run\n"
+    "\n"
+    "The remaining options are those of tricycle_engine and give the values\n"
+    "of parameters that are not fitted.\n";
+
+std::ifstream Open(const std::string& path) {
+  std::ifstream in(path.c_str());
+  if (!in) {
+    throw std::invalid_argument("cannot open " + path);
+  }
+  return in;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  std::string reference_file;
+  std::string fpp_file;
+  std::string dep_file;
+  std::string out_file;
+  std::vector<std::string> fits;
+  int duration = -1;
+  int max_evals = 5000;
+  double dt = tricycle::kMonthSeconds;
+  double start_year = 2003;
+  tricycle::SupplySpec supply;
+
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--keep-excess") {
+      supply.buy_excess = false;
+      continue;
+    } else if (arg == "-h" || arg == "--help") {
+      std::cout << kUsage;
+      return 0;
+    }
+    if (i + 1 >= argc) {
+      std::cerr << "missing value for " << arg << "\n" << kUsage;
+      return 2;
+    }
+    const char* value = argv[++i];
+    if (arg == "--reference") {
+      reference_file = value;
+    } else if (arg == "--fit") {
+      fits.push_back(value);
+    } else if (arg == "--fpp") {
+      fpp_file = value;
+    } else if (arg == "--dep") {
+      dep_file = value;
+    } else if (arg == "--out") {
+      out_file = value;
+    } else if (arg == "--duration") {
+      duration = std::atoi(value);
+    } else if (arg == "--max-evals") {
+      max_evals = std::atoi(value);
+    } else if (arg == "--start-year") {
+      start_year = std::atof(value);
+    } else if (arg == "--dt") {
+      dt = std::atof(value);
+    } else if (arg == "--initial") {
+      supply.initial_inventory = std::atof(value);
+    } else if (arg == "--supply") {
+      supply.external_supply = std::atof(value);
+    } else if (arg == "--supply-end") {
+      supply.supply_end = std::atoi(value);
+    } else if (arg == "--sales") {
+      supply.sales = std::atof(value);
+    } else if (arg == "--throughput") {
+      supply.throughput = std::atof(value);
+    } else if (arg == "--capacity") {
+      supply.capacity = std::atof(value);
+    } else {
+      std::cerr << "unknown option " << arg << "\n" << kUsage;
+      return 2;
+    }
+  }
+  if (reference_file.empty() || fits.empty() || duration < 0 || dt <= 0 ||
+      fpp_file.empty() != dep_file.empty()) {
+    std::cerr << kUsage;
+    return 2;
+  }
+
+  try {
+    std::ifstream reference_in = Open(reference_file);
+    tricycle::ReferenceCurve reference =
+        tricycle::ReadReferenceCurve(reference_in);
+
+    std::vector<tricycle::PlantSpec> specs;
+    std::vector<tricycle::Deployment> deployments;
+    if (!fpp_file.empty()) {
+      std::ifstream fpp_in = Open(fpp_file);
+      std::ifstream dep_in = Open(dep_file);
+      specs = tricycle::ReadPlantSpecs(fpp_in);
+      deployments = tricycle::ReadDeployments(dep_in);
+    }
+
+    std::vector<tricycle::FitParam> params;
+    for (const std::string& fit : fits) {
+      params.push_back(tricycle::ParseFitParam(fit));
+    }
+    tricycle::Calibration calibration(specs, deployments, supply, duration,
+                                      dt, start_year, reference, params);
+
+    std::chrono::steady_clock::time_point start =
+        std::chrono::steady_clock::now();
+    tricycle::FitResult fit = calibration.Fit(max_evals);
+    double ms = std::chrono::duration<double, std::milli>(
+                    std::chrono::steady_clock::now() - start)
+                    .count();
+
+    for (size_t p = 0; p < params.size(); ++p) {
+      std::cout << params[p].name << " = " << fit.x[p] << "\n";
+    }
+    std::cout << "rms error = " << fit.error << " kg\n";
+    std::cerr << fit.evaluations << " evaluations in " << ms << " ms ("
+              << ms / fit.evaluations << " ms each)\n";
+
+    if (!out_file.empty()) {
+      std::ofstream out(out_file.c_str());
+      tricycle::WriteRecords(calibration.Run(fit.x).records(), out);
+    }
+  } catch (const std::exception& e) {
+    std::cerr << "tricycle_calibrate: " << e.what() << "\n";
+    return 1;
+  }
+  return 0;
+}
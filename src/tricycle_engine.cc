@@ -0,0 +1,176 @@
+// tricycle_engine.cc
+//
+// Command line front end of FuelCycleEngine: runs the tritium balance of a
+// deployment given in the Scenarios/FPPInput.csv and DeployIn.csv formats,
+// without cyclus, and writes fleet totals per time step as csv.
+//
+//   tricycle_engine --fpp FPPInput.csv --dep DeployIn.csv --duration 600
+//       --initial 30 --supply 0.1 --out totals.csv
+//
+// With --realizations it runs an ensemble with plant outages instead and
+// writes percentile bands of the global tritium inventory.
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <sstream>
+#include <string>
+
+#include "fuel_cycle_engine.h"
+#include "fuel_cycle_ensemble.h"
+
+namespace {
+
+const char* kUsage =
+    "usage: tricycle_engine --fpp FILE --dep FILE --duration STEPS\n"
+    "                       [--dt SECONDS] [--initial KG] [--supply KG]\n"
+    "                       [--supply-end STEP] [--sales KG]\n"
+    "                       [--throughput KG] [--capacity KG] [--keep-excess]\n"
+    "                       [--out FILE] [--realizations N [--seed S]\n"
+    "                       [--threads N] [--percentiles P,P,...]]\n"
+    "\n"
+    "  --fpp         plant designs, FPPInput.csv format\n"
+    "  --dep         deployment schedule, DeployIn.csv format\n"
+    "  --duration    time steps to run\n"
+    "  --dt          seconds per time step (default: one month)\n"
+    "  --initial     tritium on the market at time 0 (kg)\n"
+    "  --supply      tritium reaching the market from outside every step (kg)\n"
+    "  --supply-end  time step the outside supply stops at\n"
+    "  --sales       tritium sold off the market every step (kg)\n"
+    "  --throughput  most tritium the market ships per step (kg)\n"
+    "  --capacity    most tritium the market holds (kg)\n"
+    "  --keep-excess plants keep their excess instead of selling it\n"
+    "  --out         csv file for the totals (default: stdout)\n"
+    "  --realizations  run an ensemble of N realizations with outages\n"
+    "  --seed        ensemble seed (default: 0)\n"
+    "  --threads     ensemble threads (default: all)\n"
+    "  --percentiles ensemble bands (default: 5,25,50,75,95)\n";
+
+std::ifstream Open(const std::string& path) {
+  std::ifstream in(path.c_str());
+  if (!in) {
+    throw std::invalid_argument("cannot open " + path);
+  }
+  return in;
+}
+
+std::vector<double> ParseList(const std::string& text) {
+  std::vector<double> values;
+  std::stringstream ss(text);
+  std::string item;
+  while (std::getline(ss, item, ',')) {
+    values.push_back(std::atof(item.c_str()));
+  }
+  return values;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  std::string fpp_file;
+  std::string dep_file;
+  std::string out_file;
+  int duration = -1;
+  double dt = tricycle::kMonthSeconds;
+  tricycle::SupplySpec supply;
+  tricycle::EnsembleSpec ensemble;
+  ensemble.realizations = 0;
+
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--keep-excess") {
+      supply.buy_excess = false;
+      continue;
+    } else if (arg == "-h" || arg == "--help") {
+      std::cout << kUsage;
+      return 0;
+    }
+    if (i + 1 >= argc) {
+      std::cerr << "missing value for " << arg << "\n" << kUsage;
+      return 2;
+    }
+    const char* value = argv[++i];
+    if (arg == "--fpp") {
+      fpp_file = value;
+    } else if (arg == "--dep") {
+      dep_file = value;
+    } else if (arg == "--out") {
+      out_file = value;
+    } else if (arg == "--duration") {
+      duration = std::atoi(value);
+    } else if (arg == "--dt") {
+      dt = std::atof(value);
+    } else if (arg == "--initial") {
+      supply.initial_inventory = std::atof(value);
+    } else if (arg == "--supply") {
+      supply.external_supply = std::atof(value);
+    } else if (arg == "--supply-end") {
+      supply.supply_end = std::atoi(value);
+    } else if (arg == "--sales") {
+      supply.sales = std::atof(value);
+    } else if (arg == "--throughput") {
+      supply.throughput = std::atof(value);
+    } else if (arg == "--capacity") {
+      supply.capacity = std::atof(value);
+    } else if (arg == "--realizations") {
+      ensemble.realizations = std::atoi(value);
+    } else if (arg == "--seed") {
+      ensemble.seed = std::strtoull(value, NULL, 10);
+    } else if (arg == "--threads") {
+      ensemble.threads = std::atoi(value);
+    } else if (arg == "--percentiles") {
+      ensemble.percentiles = ParseList(value);
+    } else {
+      std::cerr << "unknown option " << arg << "\n" << kUsage;
+      return 2;
+    }
+  }
+  if (fpp_file.empty() || dep_file.empty() || duration < 0 || dt <= 0) {
+    std::cerr << kUsage;
+    return 2;
+  }
+
+  try {
+    std::ifstream fpp_in = Open(fpp_file);
+    std::ifstream dep_in = Open(dep_file);
+    std::vector<tricycle::PlantSpec> specs = tricycle::ReadPlantSpecs(fpp_in);
+    std::vector<tricycle::Deployment> deployments =
+        tricycle::ReadDeployments(dep_in);
+
+    std::ofstream out_stream;
+    if (!out_file.empty()) {
+      out_stream.open(out_file.c_str());
+    }
+    std::ostream& out = out_file.empty() ? std::cout : out_stream;
+
+    std::chrono::steady_clock::time_point start =
+        std::chrono::steady_clock::now();
+    if (ensemble.realizations > 0) {
+      tricycle::EnsembleBands bands = tricycle::RunEnsemble(
+          specs, deployments, supply, duration, dt, ensemble);
+      double ms = std::chrono::duration<double, std::milli>(
+                      std::chrono::steady_clock::now() - start)
+                      .count();
+      tricycle::WriteBands(bands, out);
+      std::cerr << ensemble.realizations << " realizations of " << duration
+                << " time steps in " << ms << " ms\n";
+      return 0;
+    }
+
+    tricycle::FuelCycleEngine engine(specs, deployments, supply, duration, dt);
+    engine.Run();
+    double ms = std::chrono::duration<double, std::milli>(
+                    std::chrono::steady_clock::now() - start)
+                    .count();
+    tricycle::WriteRecords(engine.records(), out);
+    std::cerr << engine.n_plants() << " plants, " << duration
+              << " time steps in " << ms << " ms\n";
+  } catch (const std::exception& e) {
+    std::cerr << "tricycle_engine: " << e.what() << "\n";
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,316 @@
+// tritium_buffer.cc
+
+#include "tritium_buffer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "nuclides.h"
+#include "plant_kernels.h"
+#include "tritium_decay.h"
+
+using cyclus::CompMap;
+using cyclus::Composition;
+using cyclus::Material;
+using cyclus::toolkit::ResBuf;
+
+namespace tricycle {
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void TritiumLedger::Absorb(Material::Ptr mat) {
+  double qty = mat->quantity();
+  if (qty <= 0) {
+    return;
+  }
+
+  const CompMap& mass = mat->comp()->mass();
+  double total = 0;
+  for (CompMap::const_iterator it = mass.begin(); it != mass.end(); ++it) {
+    total += it->second;
+  }
+
+  for (CompMap::const_iterator it = mass.begin(); it != mass.end(); ++it) {
+    AddNuclide(it->first, qty * it->second / total);
+  }
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void TritiumLedger::Absorb(const CompMap& mass) {
+  for (CompMap::const_iterator it = mass.begin(); it != mass.end(); ++it) {
+    AddNuclide(it->first, it->second);
+  }
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void TritiumLedger::AddNuclide(int nuc, double mass) {
+  if (nuc == kTritiumId) {
+    tritium_ += mass;
+  } else if (nuc == kHelium3Id) {
+    helium3_ += mass;
+  } else {
+    other_[nuc] += mass;
+    other_mass_ += mass;
+  }
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+CompMap TritiumLedger::mass() const {
+  CompMap mass(other_);
+  if (tritium_ > 0) {
+    mass[kTritiumId] = tritium_;
+  }
+  if (helium3_ > 0) {
+    mass[kHelium3Id] = helium3_;
+  }
+  return mass;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void TritiumLedger::Add(const TritiumLedger& other) {
+  tritium_ += other.tritium_;
+  helium3_ += other.helium3_;
+  for (CompMap::const_iterator it = other.other_.begin();
+       it != other.other_.end(); ++it) {
+    other_[it->first] += it->second;
+  }
+  other_mass_ += other.other_mass_;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+TritiumLedger TritiumLedger::Extract(double qty) {
+  TritiumLedger chunk;
+  double total = quantity();
+  if (total <= 0 || qty <= 0) {
+    return chunk;
+  }
+
+  double frac = std::min(qty / total, 1.0);
+  chunk.tritium_ = tritium_ * frac;
+  chunk.helium3_ = helium3_ * frac;
+  tritium_ -= chunk.tritium_;
+  helium3_ -= chunk.helium3_;
+
+  for (CompMap::iterator it = other_.begin(); it != other_.end(); ++it) {
+    double nuc_mass = it->second * frac;
+    chunk.other_[it->first] = nuc_mass;
+    it->second -= nuc_mass;
+  }
+  chunk.other_mass_ = other_mass_ * frac;
+  other_mass_ -= chunk.other_mass_;
+
+  return chunk;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+double TritiumLedger::ExtractHelium3() {
+  double helium3 = helium3_;
+  helium3_ = 0;
+  return helium3;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void TritiumLedger::Decay(int dt, uint64_t secs_per_step) {
+  if (dt <= 0) {
+    return;
+  }
+
+  DecayStep(TritiumSurvivingFraction(dt * secs_per_step), &tritium_,
+            &helium3_);
+
+  if (other_mass_ <= 0) {
+    return;
+  }
+
+  // Anything that is not T/He-3 goes through the general decay machinery.
+  // Daughters that happen to be T or He-3 are moved over to their own totals.
+  const CompMap& decayed_other =
+      Composition::CreateFromMass(other_)->Decay(dt, secs_per_step)->mass();
+  double total = 0;
+  for (CompMap::const_iterator it = decayed_other.begin();
+       it != decayed_other.end(); ++it) {
+    total += it->second;
+  }
+
+  double other_mass = other_mass_;
+  other_.clear();
+  other_mass_ = 0;
+  for (CompMap::const_iterator it = decayed_other.begin();
+       it != decayed_other.end(); ++it) {
+    double nuc_mass = other_mass * it->second / total;
+    if (it->first == kTritiumId) {
+      tritium_ += nuc_mass;
+    } else if (it->first == kHelium3Id) {
+      helium3_ += nuc_mass;
+    } else {
+      other_[it->first] = nuc_mass;
+      other_mass_ += nuc_mass;
+    }
+  }
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+Composition::Ptr TritiumLedger::comp() const {
+  if (helium3_ <= 0 && other_mass_ <= 0) {
+    return CompRegistry::Tritium();
+  } else if (tritium_ <= 0 && other_mass_ <= 0) {
+    return CompRegistry::Helium3();
+  }
+
+  return Composition::CreateFromMass(mass());
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void TritiumBuffer::Sync() {
+  if (synced_ && std::abs(buf_->quantity() - ledger_.quantity()) <=
+                     cyclus::eps_rsrc()) {
+    return;
+  }
+
+  ledger_ = TritiumLedger();
+  if (buf_->count() == 1) {
+    held_comp_ = buf_->Peek()->comp();
+    ledger_.Absorb(buf_->Peek());
+  } else if (!buf_->empty()) {
+    std::vector<Material::Ptr> mats = buf_->PopN(buf_->count());
+    for (size_t i = 0; i < mats.size(); ++i) {
+      ledger_.Absorb(mats[i]);
+    }
+    buf_->Push(mats);
+    held_comp_ = buf_->Peek()->comp();
+  }
+
+  if (!tracked_) {
+    Untrack(buf_);
+  }
+
+  stale_ = false;
+  synced_ = true;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void TritiumBuffer::Restore(const TritiumLedger& ledger) {
+  if (std::abs(buf_->quantity() - ledger.quantity()) > cyclus::eps_rsrc()) {
+    synced_ = false;
+    return;
+  }
+  ledger_ = ledger;
+  held_comp_ = buf_->empty() ? Composition::Ptr() : buf_->Peek()->comp();
+  stale_ = !buf_->empty();
+  synced_ = true;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void TritiumBuffer::Decay(int dt, uint64_t secs_per_step) {
+  if (dt <= 0 || ledger_.empty()) {
+    return;
+  }
+  ledger_.Decay(dt, secs_per_step);
+  stale_ = true;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+Material::Ptr TritiumBuffer::ExtractHelium3() {
+  double helium3 = ledger_.helium3();
+  if (helium3 <= cyclus::eps_rsrc()) {
+    return Material::Ptr();
+  }
+
+  ledger_.ExtractHelium3();
+  Material::Ptr helium = buf_->Pop(helium3);
+  helium->Transmute(CompRegistry::Helium3());
+
+  // Once the helium-3 is gone a pure tritium inventory is back to the
+  // composition its material already carries.
+  stale_ = (ledger_.comp() != held_comp_);
+  return helium;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+Material::Ptr TritiumBuffer::Pop(double qty) {
+  TritiumLedger chunk = ledger_.Extract(qty);
+  Material::Ptr mat = buf_->Pop(qty);
+  mat->Transmute(chunk.comp());
+  return mat;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+TritiumLedger TritiumBuffer::Remove(double qty) {
+  TritiumLedger chunk = ledger_.Extract(qty);
+  buf_->Pop(qty);
+  return chunk;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void TritiumBuffer::Transfer(TritiumBuffer* to, double qty) {
+  TritiumLedger chunk = ledger_.Extract(qty);
+  Material::Ptr mat = buf_->Pop(qty);
+  to->ledger_.Add(chunk);
+  to->PushMaterial(mat, stale_);
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void TritiumBuffer::Push(Material::Ptr mat) {
+  ledger_.Absorb(mat);
+  PushMaterial(mat, false);
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void TritiumBuffer::Materialize() {
+  if (!stale_ || buf_->empty()) {
+    return;
+  }
+  held_comp_ = ledger_.comp();
+  buf_->Peek()->Transmute(held_comp_);
+  stale_ = false;
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void TritiumBuffer::PushMaterial(Material::Ptr mat, bool mat_stale) {
+  if (buf_->empty()) {
+    held_comp_ = mat->comp();
+    stale_ = mat_stale;
+  } else if (mat_stale || mat->comp() != held_comp_) {
+    stale_ = true;
+  }
+  buf_->Push(mat);
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void Untrack(ResBuf<Material>* buf) {
+  std::vector<Material::Ptr> mats = buf->PopN(buf->count());
+  for (size_t i = 0; i < mats.size(); ++i) {
+    buf->Push(Material::CreateUntracked(mats[i]->quantity(), mats[i]->comp()));
+  }
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void TrackedLot::Open(ResBuf<Material>* buf, cyclus::Agent* owner) {
+  if (buf->quantity() <= cyclus::eps_rsrc()) {
+    return;
+  }
+
+  TritiumLedger contents;
+  std::vector<Material::Ptr> mats = buf->PopN(buf->count());
+  for (size_t i = 0; i < mats.size(); ++i) {
+    contents.Absorb(mats[i]);
+  }
+
+  // The parent is left empty after each split and only grows again by
+  // what the next lot brings in
+  double qty = contents.quantity();
+  Material::Ptr lot = Material::Create(owner, qty, contents.comp());
+  if (!parent_) {
+    parent_ = lot;
+  } else {
+    parent_->Absorb(lot);
+  }
+  buf->Push(parent_->ExtractQty(qty));
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void TrackedLot::Close(ResBuf<Material>* buf) {
+  Untrack(buf);
+}
+
+}  // namespace tricycle
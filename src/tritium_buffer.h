@@ -0,0 +1,179 @@
+#ifndef CYCLUS_TRICYCLE_TRITIUM_BUFFER_H_
+#define CYCLUS_TRICYCLE_TRITIUM_BUFFER_H_
+
+#include <cstdint>
+
+#include "cyclus.h"
+
+namespace tricycle {
+
+/// @class TritiumLedger
+/// Running per-nuclide mass totals (kg) of a tritium inventory. Tritium and
+/// helium-3 are kept as plain numbers; anything else that ends up in the
+/// inventory (e.g. the wrong fuel being delivered) is kept as a mass map so
+/// it can still be accounted for. All queries are O(1) for T/He-3
+/// inventories and no cyclus::Material is ever created by the ledger itself.
+class TritiumLedger {
+ public:
+  TritiumLedger() : tritium_(0), helium3_(0), other_mass_(0) {}
+
+  double tritium() const { return tritium_; }
+  double helium3() const { return helium3_; }
+  /// Mass of every nuclide that is neither T-3 nor He-3
+  double other() const { return other_mass_; }
+  double quantity() const { return tritium_ + helium3_ + other_mass_; }
+  bool empty() const { return quantity() <= cyclus::eps_rsrc(); }
+
+  /// True if the inventory is tritium and nothing else
+  bool pure() const { return cyclus::AlmostEq(tritium_, quantity()); }
+
+  /// Adds the nuclide masses of mat to the ledger
+  void Absorb(cyclus::Material::Ptr mat);
+
+  /// Adds nuclide masses (kg), as returned by mass()
+  void Absorb(const cyclus::CompMap& mass);
+
+  /// Nuclide masses (kg) of the inventory, to save it across a restart
+  cyclus::CompMap mass() const;
+
+  /// Adds the contents of another ledger
+  void Add(const TritiumLedger& other);
+
+  /// Adds mass kg of pure tritium
+  void AddTritium(double mass) { tritium_ += mass; }
+
+  /// Removes qty kg with the current composition and returns it as a ledger
+  TritiumLedger Extract(double qty);
+
+  /// Removes all helium-3 and returns its mass
+  double ExtractHelium3();
+
+  /// Decays the inventory by dt timesteps of secs_per_step seconds. T/He-3
+  /// are handled in closed form, any other nuclides through
+  /// cyclus::Composition::Decay.
+  void Decay(int dt, uint64_t secs_per_step);
+
+  /// Composition of the inventory. Pure tritium always returns the same
+  /// shared composition.
+  cyclus::Composition::Ptr comp() const;
+
+ private:
+  void AddNuclide(int nuc, double mass);
+
+  double tritium_;
+  double helium3_;
+  double other_mass_;
+  cyclus::CompMap other_;
+};
+
+/// @class TritiumBuffer
+/// Keeps a TritiumLedger in step with a bulk ResBuf<Material> so that the
+/// buffer can still be handed to buy/sell policies and inventory trackers,
+/// while decay, helium-3 extraction and purity checks work on the ledger.
+/// The composition of the material held by the buffer is only brought up to
+/// date (Materialize) right before it can cross a trade boundary, and
+/// materials popped out of the buffer always carry the ledger composition.
+///
+/// Trades change the buffer behind the ledger's back, so Sync must be called
+/// after the exchange and before the ledger is used again.
+class TritiumBuffer {
+ public:
+  TritiumBuffer()
+      : buf_(NULL), stale_(false), synced_(false), tracked_(true) {}
+
+  /// Binds the ledger to a bulk buffer
+  void Init(cyclus::toolkit::ResBuf<cyclus::Material>* buf) {
+    buf_ = buf;
+    synced_ = false;
+  }
+
+  /// If tracked is false, whatever a trade leaves in the buffer is swapped
+  /// for an untracked copy on the next Sync, so that internal pops, splits
+  /// and transmutations are never written to the Resources table.
+  void set_tracked(bool tracked) { tracked_ = tracked; }
+
+  const TritiumLedger& ledger() const { return ledger_; }
+  double tritium() const { return ledger_.tritium(); }
+  double helium3() const { return ledger_.helium3(); }
+  double quantity() const { return ledger_.quantity(); }
+  bool pure() const { return ledger_.pure(); }
+
+  /// Re-reads the ledger from the buffer if it was changed by a trade
+  void Sync();
+
+  /// Replaces the ledger with one saved for the material now in the buffer,
+  /// e.g. on restart. The buffered material is brought up to date with it
+  /// on the next Materialize. A ledger that does not add up to the buffered
+  /// quantity is ignored and the buffer re-read on the next Sync instead.
+  void Restore(const TritiumLedger& ledger);
+
+  /// Decays the ledger; the buffered material is not touched
+  void Decay(int dt, uint64_t secs_per_step);
+
+  /// Pops all of the helium-3 out of the buffer as pure He-3 material.
+  /// Returns a null pointer if there is no helium-3 to extract.
+  cyclus::Material::Ptr ExtractHelium3();
+
+  /// Pops qty kg out of the buffer carrying the ledger composition
+  cyclus::Material::Ptr Pop(double qty);
+
+  /// Pops qty kg out of the buffer for internal use, only returning the
+  /// nuclide masses removed
+  TritiumLedger Remove(double qty);
+
+  /// Moves qty kg into another tritium buffer
+  void Transfer(TritiumBuffer* to, double qty);
+
+  /// Pushes mat into the buffer and adds it to the ledger
+  void Push(cyclus::Material::Ptr mat);
+
+  /// Brings the composition of the buffered material up to date with the
+  /// ledger so that it can be traded
+  void Materialize();
+
+ private:
+  /// Pushes mat into the buffer, keeping track of whether the buffered
+  /// material still agrees with the ledger
+  void PushMaterial(cyclus::Material::Ptr mat, bool mat_stale);
+
+  cyclus::toolkit::ResBuf<cyclus::Material>* buf_;
+  TritiumLedger ledger_;
+
+  /// Composition last given to (or read from) the buffered material
+  cyclus::Composition::Ptr held_comp_;
+
+  /// True if the buffered material's composition lags the ledger
+  bool stale_;
+  bool synced_;
+  bool tracked_;
+};
+
+/// Replaces every material in buf by an untracked copy with the same
+/// quantity and composition. The originals keep their last recorded state.
+void Untrack(cyclus::toolkit::ResBuf<cyclus::Material>* buf);
+
+/// @class TrackedLot
+/// Hands the untracked contents of a buffer over to a trade as one tracked
+/// material. Every lot is split off the same tracked parent, which absorbs
+/// what is about to be sold, so a sold material always has a recorded parent
+/// and the lots sold out of one buffer share a parent chain. The parent is
+/// not saved with the agent; a restarted agent starts a new chain.
+class TrackedLot {
+ public:
+  /// Swaps the contents of buf for a single tracked lot, the parent being
+  /// created by owner on the first call
+  void Open(cyclus::toolkit::ResBuf<cyclus::Material>* buf,
+            cyclus::Agent* owner);
+
+  /// Swaps what the trades left of the lot for an untracked copy
+  void Close(cyclus::toolkit::ResBuf<cyclus::Material>* buf);
+
+  cyclus::Material::Ptr parent() const { return parent_; }
+
+ private:
+  cyclus::Material::Ptr parent_;
+};
+
+}  // namespace tricycle
+
+#endif  // CYCLUS_TRICYCLE_TRITIUM_BUFFER_H_
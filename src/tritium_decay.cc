@@ -0,0 +1,16 @@
+// tritium_decay.cc
+
+#include "tritium_decay.h"
+
+#include "plant_kernels.h"
+
+namespace tricycle {
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+double TritiumSurvivingFraction(uint64_t secs) {
+  // One exp is cheaper than a lookup, and keeps this free of shared state
+  // for the ensemble's threads
+  return TritiumSurvival(secs);
+}
+
+}  // namespace tricycle
@@ -0,0 +1,13 @@
+#ifndef CYCLUS_TRICYCLE_TRITIUM_DECAY_H_
+#define CYCLUS_TRICYCLE_TRITIUM_DECAY_H_
+
+#include <cstdint>
+
+namespace tricycle {
+
+/// Fraction of tritium atoms remaining after secs seconds
+double TritiumSurvivingFraction(uint64_t secs);
+
+}  // namespace tricycle
+
+#endif  // CYCLUS_TRICYCLE_TRITIUM_DECAY_H_
@@ -0,0 +1,28 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+
+#include "context.h"
+#include "nuclide_data.h"
+#include "tritium_decay.h"
+
+namespace tricycle {
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+TEST(TritiumDecayTest, SurvivingFraction) {
+  EXPECT_DOUBLE_EQ(1.0, TritiumSurvivingFraction(0));
+  EXPECT_NEAR(0.5,
+              TritiumSurvivingFraction(static_cast<uint64_t>(kTritiumHalfLife)),
+              1e-12);
+
+  // Follows the exponential decay law
+  double month = kDefaultTimeStepDur;
+  double expected = std::exp(-std::log(2.0) * month / kTritiumHalfLife);
+  EXPECT_NEAR(expected, TritiumSurvivingFraction(kDefaultTimeStepDur), 1e-15);
+
+  double year = 12 * month;
+  EXPECT_NEAR(std::exp(-std::log(2.0) * year / kTritiumHalfLife),
+              TritiumSurvivingFraction(12 * kDefaultTimeStepDur), 1e-15);
+}
+
+}  // namespace tricycle